@@ -1,3 +1,10 @@
 mkdir .\output
-g++ -std=c++17 -O2  .\src\main.cpp .\src\Lexer.cpp .\src\LR1Parser.cpp .\src\SemanticAnalyzer.cpp -o .\output\Translator.exe
+mkdir .\output\obj
+rem 除 main.cpp 外的源文件编译为静态库 libtranslator.a，命令行程序和测试程序(test\compile_test.cpp)都链接它
+del /q .\output\obj\*.o .\output\libtranslator.a 2>nul
+for %%s in (Lexer LR1Parser SemanticAnalyzer Arena CompactTree ParseStats ThreadPool Pipeline CompileServer Compiler BatchIO CompileCache Interner IRBuffer SymbolTable TempSlots IRWriter IRReader Optimizer) do g++ -std=c++17 -O2 -c .\src\%%s.cpp -o .\output\obj\%%s.o || exit /b 1
+ar rcs .\output\libtranslator.a .\output\obj\*.o
+g++ -std=c++17 -O2  .\src\main.cpp .\output\libtranslator.a -pthread -o .\output\Translator.exe
+g++ -std=c++17 -O2  .\test\compile_test.cpp .\output\libtranslator.a -pthread -o .\output\CompileTest.exe
+.\output\CompileTest.exe
 .\output\Translator.exe .\test\input\input.txt .\test\grammer\grammer.txt
\ No newline at end of file
@@ -1,4 +1,13 @@
-mkdir ./output
-g++ -std=c++17 -O2 ./src/main.cpp ./src/Lexer.cpp ./src/LR1Parser.cpp ./src/SemanticAnalyzer.cpp -o ./output/Translator
+mkdir -p ./output/obj
+# 除 main.cpp 外的源文件编译为静态库 libtranslator.a，命令行程序和测试程序(test/compile_test.cpp)都链接它
+LIB_SOURCES="./src/Lexer.cpp ./src/LR1Parser.cpp ./src/SemanticAnalyzer.cpp ./src/Arena.cpp ./src/CompactTree.cpp ./src/ParseStats.cpp ./src/ThreadPool.cpp ./src/Pipeline.cpp ./src/CompileServer.cpp ./src/Compiler.cpp ./src/BatchIO.cpp ./src/CompileCache.cpp ./src/Interner.cpp ./src/IRBuffer.cpp ./src/SymbolTable.cpp ./src/TempSlots.cpp ./src/IRWriter.cpp ./src/IRReader.cpp ./src/Optimizer.cpp"
+rm -f ./output/obj/*.o ./output/libtranslator.a
+for source in $LIB_SOURCES; do
+	g++ -std=c++17 -O2 -c $source -o ./output/obj/$(basename $source .cpp).o || exit 1
+done
+ar rcs ./output/libtranslator.a ./output/obj/*.o
+g++ -std=c++17 -O2 ./src/main.cpp ./output/libtranslator.a -pthread -o ./output/Translator
+g++ -std=c++17 -O2 ./test/compile_test.cpp ./output/libtranslator.a -pthread -o ./output/CompileTest
 
+./output/CompileTest
 ./output/Translator ./test/input/input.txt test/grammer/grammer.txt
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "Arena.hpp"
+#include <cstdint>
+#include <cstdlib>
+
+void* Arena::allocate(size_t size, size_t align)
+{
+	uintptr_t current = reinterpret_cast<uintptr_t>(cursor);
+	uintptr_t aligned = (current + align - 1) & ~(uintptr_t)(align - 1);
+
+	if (cursor == nullptr || aligned + size > reinterpret_cast<uintptr_t>(limit)) {
+		// 当前块放不下，新开一块；超过块大小的请求单独占一块
+		new_block(size + align);
+		current = reinterpret_cast<uintptr_t>(cursor);
+		aligned = (current + align - 1) & ~(uintptr_t)(align - 1);
+	}
+
+	cursor = reinterpret_cast<char*>(aligned + size);
+	used += size;
+	return reinterpret_cast<void*>(aligned);
+}
+
+void Arena::new_block(size_t min_size)
+{
+	size_t size = min_size > block_size ? min_size : block_size;
+	void* memory = std::malloc(sizeof(Block) + size);
+	if (memory == nullptr) throw std::bad_alloc();
+
+	Block* block = static_cast<Block*>(memory);
+	block->prev = head;
+	block->size = size;
+	head = block;
+
+	cursor = reinterpret_cast<char*>(block + 1);
+	limit = cursor + size;
+}
+
+void Arena::add_finalizer(void* object, void (*destroy)(void*))
+{
+	Finalizer* finalizer = static_cast<Finalizer*>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+	finalizer->prev = finalizers;
+	finalizer->destroy = destroy;
+	finalizer->object = object;
+	finalizers = finalizer;
+}
+
+void Arena::release()
+{
+	// 后构造的先析构
+	for (Finalizer* f = finalizers; f != nullptr; f = f->prev) {
+		f->destroy(f->object);
+	}
+	finalizers = nullptr;
+
+	while (head != nullptr) {
+		Block* prev = head->prev;
+		std::free(head);
+		head = prev;
+	}
+	cursor = limit = nullptr;
+	used = 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 线性(bump)分配器：按固定大小分块申请内存，块内只移动指针，不单独释放
+// 一次编译的语法树结点和子结点数组都放在这里，编译结束时整体释放
+class Arena {
+public:
+	explicit Arena(size_t block_size = 64 * 1024) : block_size(block_size) {}
+	~Arena() { release(); }
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+	// 在 Arena 中构造一个对象，非平凡析构的对象会在 release() 时析构
+	template <typename T, typename... Args>
+	T* create(Args&&... args)
+	{
+		void* memory = allocate(sizeof(T), alignof(T));
+		T* object = new (memory) T(std::forward<Args>(args)...);
+		if (!std::is_trivially_destructible<T>::value) {
+			add_finalizer(object, [](void* p) { static_cast<T*>(p)->~T(); });
+		}
+		return object;
+	}
+
+	// 申请一段未初始化的数组，只用于平凡类型(如指针数组)
+	template <typename T>
+	T* allocate_array(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "allocate_array 只支持平凡析构的类型");
+		if (count == 0) return nullptr;
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// 释放全部内存：依次析构登记过的对象，然后归还所有块
+	void release();
+
+	size_t bytes_used() const { return used; }
+
+private:
+	struct Block
+	{
+		Block* prev;
+		size_t size;  // 块中可用的字节数(不含块头)
+	};
+
+	struct Finalizer
+	{
+		Finalizer* prev;
+		void (*destroy)(void*);
+		void* object;
+	};
+
+	void add_finalizer(void* object, void (*destroy)(void*));
+	void new_block(size_t min_size);
+
+private:
+	size_t block_size;
+	Block* head = nullptr;
+	char* cursor = nullptr;  // 当前块中下一个可用位置
+	char* limit = nullptr;   // 当前块的末尾
+	Finalizer* finalizers = nullptr;
+	size_t used = 0;
+};
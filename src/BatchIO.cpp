@@ -0,0 +1,464 @@
+#include "BatchIO.hpp"
+#include "ThreadPool.hpp"
+
+#ifdef _WIN32
+#include <fstream>
+#include <sstream>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && !defined(NO_IO_URING) && __has_include(<linux/io_uring.h>)
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define BATCH_IO_URING
+#endif
+#endif
+
+#ifdef BATCH_IO_URING
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <linux/io_uring.h>
+#include <mutex>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <thread>
+#include <vector>
+#endif
+
+namespace {
+#ifdef _WIN32
+	FileData read_whole_file(const std::string& path)
+	{
+		FileData file;
+		std::ifstream in(path);
+		if (!in.is_open()) return file;
+		std::stringstream buffer;
+		buffer << in.rdbuf();
+		file.content = buffer.str();
+		file.ok = true;
+		return file;
+	}
+
+	bool write_whole_file(const std::string& path, const std::string& content)
+	{
+		std::ofstream out(path);
+		if (!out) return false;
+		out << content;
+		return static_cast<bool>(out);
+	}
+#else
+	// 普通文件按 fstat 得到的大小一次分配好，管道等大小未知的文件边读边扩大
+	FileData read_whole_file(const std::string& path)
+	{
+		FileData file;
+		int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) return file;
+
+		struct stat info;
+		bool regular = ::fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+		if (regular) file.content.resize(info.st_size);
+
+		size_t done = 0;
+		file.ok = true;
+		while (true) {
+			if (done == file.content.size()) {
+				if (regular) break;
+				file.content.resize(done < 4096 ? 4096 : done * 2);
+			}
+			ssize_t n = ::pread(fd, &file.content[done], file.content.size() - done, done);
+			if (n < 0 && errno == EINTR) continue;
+			if (n < 0) file.ok = false;
+			if (n <= 0) break;
+			done += n;
+		}
+		file.content.resize(file.ok ? done : 0);
+		::close(fd);
+		return file;
+	}
+
+	bool write_whole_file(const std::string& path, const std::string& content)
+	{
+		int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0) return false;
+
+		size_t done = 0;
+		while (done < content.size()) {
+			ssize_t n = ::pwrite(fd, content.data() + done, content.size() - done, done);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) break;
+			done += n;
+		}
+		return ::close(fd) == 0 && done == content.size();
+	}
+#endif
+}  // namespace
+
+#ifdef BATCH_IO_URING
+
+// 直接通过系统调用使用 io_uring，不依赖 liburing
+// 只用到 READV、WRITEV 和 POLL_ADD(Linux 5.1 起都支持)；打开文件仍在 I/O 线程中同步进行
+struct BatchIO::Ring
+{
+	struct Request
+	{
+		bool write = false;
+		std::string path;
+		std::string data;  // 读入的内容或要写出的内容
+		size_t done = 0;   // 已经读写的字节数
+		int fd = -1;
+		iovec iov;
+		std::promise<FileData> read_result;
+		std::promise<bool> write_result;
+	};
+
+	static std::unique_ptr<Ring> create(unsigned entries);
+	~Ring();
+
+	// 可以在任意线程中调用
+	void submit(std::unique_ptr<Request> request);
+
+	// 以下只在 I/O 线程中调用
+	void run();
+	void start(Request* request);
+	void finish(Request* request, bool ok);
+	void complete(Request* request, int result);
+	void push_sqe(const io_uring_sqe& sqe);
+	void arm_wakeup();
+	void enter();
+	void reap();
+
+	int ring_fd = -1;
+	int wake_fd = -1;  // eventfd，有新请求时唤醒 I/O 线程
+	io_uring_params params{};
+	void* sq_ring = MAP_FAILED;
+	void* cq_ring = MAP_FAILED;
+	void* sqe_memory = MAP_FAILED;
+	size_t sq_ring_size = 0;
+	size_t cq_ring_size = 0;
+	size_t sqe_memory_size = 0;
+
+	unsigned* sq_tail = nullptr;
+	unsigned* sq_mask = nullptr;
+	unsigned* sq_array = nullptr;
+	io_uring_sqe* sqes = nullptr;
+	unsigned* cq_head = nullptr;
+	unsigned* cq_tail = nullptr;
+	unsigned* cq_mask = nullptr;
+	io_uring_cqe* cqes = nullptr;
+
+	unsigned to_submit = 0;        // 已经填好、尚未交给内核的 sqe 数
+	size_t in_flight = 0;          // 已经交给内核、尚未完成的读写数(不含唤醒用的 poll)
+	std::deque<Request*> waiting;  // 已经打开文件、等待提交读写的请求
+
+	std::mutex mutex;  // 保护 incoming 和 stopping
+	std::vector<std::unique_ptr<Request>> incoming;
+	bool stopping = false;
+	std::thread thread;
+};
+
+std::unique_ptr<BatchIO::Ring> BatchIO::Ring::create(unsigned entries)
+{
+	auto ring = std::make_unique<Ring>();
+	int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &ring->params));
+	if (fd < 0) return nullptr;
+	ring->ring_fd = fd;
+
+	const io_uring_params& p = ring->params;
+	ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+	bool single_mmap = p.features & IORING_FEAT_SINGLE_MMAP;
+	if (single_mmap) {
+		ring->sq_ring_size = ring->cq_ring_size = std::max(ring->sq_ring_size, ring->cq_ring_size);
+	}
+
+	ring->sq_ring = ::mmap(nullptr, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (ring->sq_ring == MAP_FAILED) return nullptr;
+	if (single_mmap) {
+		ring->cq_ring = ring->sq_ring;
+	} else {
+		ring->cq_ring = ::mmap(nullptr, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (ring->cq_ring == MAP_FAILED) return nullptr;
+	}
+	ring->sqe_memory_size = p.sq_entries * sizeof(io_uring_sqe);
+	ring->sqe_memory = ::mmap(nullptr, ring->sqe_memory_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (ring->sqe_memory == MAP_FAILED) return nullptr;
+
+	char* sq = static_cast<char*>(ring->sq_ring);
+	char* cq = static_cast<char*>(ring->cq_ring);
+	ring->sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+	ring->sq_mask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+	ring->sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+	ring->sqes = static_cast<io_uring_sqe*>(ring->sqe_memory);
+	ring->cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+	ring->cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+	ring->cq_mask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+	ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+	ring->wake_fd = ::eventfd(0, EFD_CLOEXEC);
+	if (ring->wake_fd < 0) return nullptr;
+
+	ring->thread = std::thread(&Ring::run, ring.get());
+	return ring;
+}
+
+BatchIO::Ring::~Ring()
+{
+	if (thread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		uint64_t one = 1;
+		(void)::write(wake_fd, &one, sizeof(one));
+		thread.join();
+	}
+
+	if (sqe_memory != MAP_FAILED) ::munmap(sqe_memory, sqe_memory_size);
+	if (cq_ring != MAP_FAILED && cq_ring != sq_ring) ::munmap(cq_ring, cq_ring_size);
+	if (sq_ring != MAP_FAILED) ::munmap(sq_ring, sq_ring_size);
+	if (wake_fd >= 0) ::close(wake_fd);
+	if (ring_fd >= 0) ::close(ring_fd);
+}
+
+void BatchIO::Ring::submit(std::unique_ptr<Request> request)
+{
+	// 只有队列从空变为非空时才需要唤醒，否则 I/O 线程已经收到过通知
+	bool wake;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		wake = incoming.empty();
+		incoming.push_back(std::move(request));
+	}
+	if (wake) {
+		uint64_t one = 1;
+		(void)::write(wake_fd, &one, sizeof(one));
+	}
+}
+
+void BatchIO::Ring::run()
+{
+	// 读写最多占 sq_entries - 1 个位置，留一个给唤醒用的 poll，完成队列(2 倍大小)不会溢出
+	size_t max_in_flight = params.sq_entries - 1;
+
+	arm_wakeup();
+	while (true) {
+		std::vector<std::unique_ptr<Request>> batch;
+		bool stop;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			batch.swap(incoming);
+			stop = stopping;
+		}
+		for (auto& request : batch) start(request.release());
+
+		while (!waiting.empty() && in_flight < max_in_flight) {
+			Request* request = waiting.front();
+			waiting.pop_front();
+
+			io_uring_sqe sqe;
+			std::memset(&sqe, 0, sizeof(sqe));
+			request->iov.iov_base = &request->data[request->done];
+			request->iov.iov_len = request->data.size() - request->done;
+			sqe.opcode = request->write ? IORING_OP_WRITEV : IORING_OP_READV;
+			sqe.fd = request->fd;
+			sqe.off = request->done;
+			sqe.addr = reinterpret_cast<uint64_t>(&request->iov);
+			sqe.len = 1;
+			sqe.user_data = reinterpret_cast<uint64_t>(request);
+			push_sqe(sqe);
+			++in_flight;
+		}
+
+		// 停止后不会再有新请求，已经打开的请求都在 waiting 中或已交给内核
+		if (stop && waiting.empty() && in_flight == 0) break;
+
+		enter();
+		reap();
+	}
+}
+
+void BatchIO::Ring::start(Request* request)
+{
+	if (request->write) {
+		request->fd = ::open(request->path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (request->fd < 0 || request->data.empty()) {
+			finish(request, request->fd >= 0);
+			return;
+		}
+		waiting.push_back(request);
+		return;
+	}
+
+	request->fd = ::open(request->path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (request->fd < 0) {
+		finish(request, false);
+		return;
+	}
+	struct stat info;
+	if (::fstat(request->fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+		// 大小未知的文件不走 io_uring
+		::close(request->fd);
+		request->read_result.set_value(read_whole_file(request->path));
+		delete request;
+		return;
+	}
+	if (info.st_size == 0) {
+		finish(request, true);
+		return;
+	}
+	request->data.resize(info.st_size);
+	waiting.push_back(request);
+}
+
+void BatchIO::Ring::finish(Request* request, bool ok)
+{
+	if (request->fd >= 0 && ::close(request->fd) != 0 && request->write) ok = false;
+	if (request->write) {
+		request->write_result.set_value(ok);
+	} else {
+		FileData file;
+		file.ok = ok;
+		if (ok) file.content = std::move(request->data);
+		request->read_result.set_value(std::move(file));
+	}
+	delete request;
+}
+
+void BatchIO::Ring::complete(Request* request, int result)
+{
+	--in_flight;
+	if (result == -EINTR || result == -EAGAIN) {
+		waiting.push_back(request);
+	} else if (result < 0 || (result == 0 && request->write)) {
+		finish(request, false);
+	} else if (result == 0) {
+		// 文件在读取期间变短
+		request->data.resize(request->done);
+		finish(request, true);
+	} else {
+		request->done += result;
+		if (request->done < request->data.size()) {
+			waiting.push_back(request);
+		} else {
+			finish(request, true);
+		}
+	}
+}
+
+void BatchIO::Ring::push_sqe(const io_uring_sqe& sqe)
+{
+	// 每次 enter() 都会把填好的 sqe 全部交给内核，提交队列在这里不会满
+	unsigned tail = *sq_tail;
+	unsigned index = tail & *sq_mask;
+	sqes[index] = sqe;
+	sq_array[index] = index;
+	__atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+	++to_submit;
+}
+
+void BatchIO::Ring::arm_wakeup()
+{
+	io_uring_sqe sqe;
+	std::memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = IORING_OP_POLL_ADD;
+	sqe.fd = wake_fd;
+	sqe.poll_events = POLLIN;
+	sqe.user_data = 0;
+	push_sqe(sqe);
+}
+
+void BatchIO::Ring::enter()
+{
+	// 提交填好的 sqe，并等待至少一个完成事件(读写完成或有新请求)
+	while (true) {
+		long submitted = ::syscall(__NR_io_uring_enter, ring_fd, to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+		if (submitted >= 0) {
+			to_submit -= static_cast<unsigned>(submitted);
+			return;
+		}
+		if (errno != EINTR) return;
+	}
+}
+
+void BatchIO::Ring::reap()
+{
+	unsigned head = *cq_head;
+	unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+	for (; head != tail; ++head) {
+		const io_uring_cqe& cqe = cqes[head & *cq_mask];
+		if (cqe.user_data == 0) {
+			uint64_t count;
+			(void)::read(wake_fd, &count, sizeof(count));
+			arm_wakeup();
+		} else {
+			complete(reinterpret_cast<Request*>(cqe.user_data), cqe.res);
+		}
+	}
+	__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+}
+
+#else
+
+struct BatchIO::Ring
+{
+};
+
+#endif
+
+BatchIO::BatchIO(size_t queue_depth, size_t fallback_threads)
+{
+#ifdef BATCH_IO_URING
+	ring = Ring::create(static_cast<unsigned>(queue_depth));
+	if (ring != nullptr) return;
+#else
+	(void)queue_depth;
+#endif
+	fallback = std::make_unique<ThreadPool>(fallback_threads);
+}
+
+BatchIO::~BatchIO() = default;
+
+std::future<FileData> BatchIO::read(const std::string& path)
+{
+#ifdef BATCH_IO_URING
+	if (ring != nullptr) {
+		auto request = std::make_unique<Ring::Request>();
+		request->path = path;
+		std::future<FileData> result = request->read_result.get_future();
+		ring->submit(std::move(request));
+		return result;
+	}
+#endif
+	auto promise = std::make_shared<std::promise<FileData>>();
+	std::future<FileData> result = promise->get_future();
+	fallback->submit([promise, path]() { promise->set_value(read_whole_file(path)); });
+	return result;
+}
+
+std::future<bool> BatchIO::write(const std::string& path, std::string content)
+{
+#ifdef BATCH_IO_URING
+	if (ring != nullptr) {
+		auto request = std::make_unique<Ring::Request>();
+		request->write = true;
+		request->path = path;
+		request->data = std::move(content);
+		std::future<bool> result = request->write_result.get_future();
+		ring->submit(std::move(request));
+		return result;
+	}
+#endif
+	auto promise = std::make_shared<std::promise<bool>>();
+	std::future<bool> result = promise->get_future();
+	auto data = std::make_shared<std::string>(std::move(content));
+	fallback->submit([promise, path, data]() { promise->set_value(write_whole_file(path, *data)); });
+	return result;
+}
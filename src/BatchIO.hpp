@@ -0,0 +1,37 @@
+#pragma once
+
+#include <future>
+#include <memory>
+#include <string>
+
+class ThreadPool;
+
+struct FileData
+{
+	bool ok = false;  // 文件打不开或读取出错时为 false
+	std::string content;
+};
+
+// 批量编译用的异步文件读写
+// Linux 上使用 io_uring：请求交给一个 I/O 线程，攒成一批后一次提交给内核，读写与编译重叠进行；
+// io_uring 不可用(内核太旧、被禁用，或编译时定义了 NO_IO_URING)时，退回到线程池中逐个 pread/pwrite
+class BatchIO {
+public:
+	explicit BatchIO(size_t queue_depth = 64, size_t fallback_threads = 4);
+	// 等待已提交的读写全部完成后再退出
+	~BatchIO();
+
+	BatchIO(const BatchIO&) = delete;
+	BatchIO& operator=(const BatchIO&) = delete;
+
+	// 读入整个文件
+	std::future<FileData> read(const std::string& path);
+	// 创建或覆盖文件，写入 content，写完后 future 为 true
+	std::future<bool> write(const std::string& path, std::string content);
+
+private:
+	struct Ring;
+
+	std::unique_ptr<Ring> ring;
+	std::unique_ptr<ThreadPool> fallback;
+};
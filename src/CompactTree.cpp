@@ -0,0 +1,62 @@
+#include "CompactTree.hpp"
+
+uint32_t CompactTree::intern_symbol(const Symbol& symbol)
+{
+	auto it = symbol_ids.find(symbol.literal);
+	if (it != symbol_ids.end()) return it->second;
+
+	uint32_t id = static_cast<uint32_t>(symbols.size());
+	symbols.push_back(Symbol(symbol.type, symbol.literal));
+	symbol_ids.emplace(symbol.literal, id);
+	return id;
+}
+
+uint32_t CompactTree::add_leaf(const Symbol& symbol)
+{
+	uint32_t node = static_cast<uint32_t>(size());
+	uint32_t token = static_cast<uint32_t>(token_offset.size() - 1);
+
+	token_text += symbol.real_value;
+	token_offset.push_back(static_cast<uint32_t>(token_text.size()));
+
+	symbol_id.push_back(intern_symbol(symbol));
+	token_index.push_back(token);
+	production_id.push_back(npos);
+	first_child.push_back(static_cast<uint32_t>(child_index.size()));
+	child_count.push_back(0);
+	return node;
+}
+
+uint32_t CompactTree::add_node(const Symbol& lhs, uint32_t production, const uint32_t* children, size_t count)
+{
+	uint32_t node = static_cast<uint32_t>(size());
+
+	symbol_id.push_back(intern_symbol(lhs));
+	token_index.push_back(npos);
+	production_id.push_back(production);
+	first_child.push_back(static_cast<uint32_t>(child_index.size()));
+	child_count.push_back(static_cast<uint32_t>(count));
+	child_index.insert(child_index.end(), children, children + count);
+	return node;
+}
+
+std::string CompactTree::token_value(uint32_t node) const
+{
+	uint32_t token = token_index[node];
+	if (token == npos) return "";
+	return token_text.substr(token_offset[token], token_offset[token + 1] - token_offset[token]);
+}
+
+void CompactTree::clear()
+{
+	symbol_id.clear();
+	token_index.clear();
+	production_id.clear();
+	first_child.clear();
+	child_count.clear();
+	child_index.clear();
+	symbols.clear();
+	symbol_ids.clear();
+	token_text.clear();
+	token_offset.assign(1, 0);
+}
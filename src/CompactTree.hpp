@@ -0,0 +1,49 @@
+#pragma once
+
+#include "LR1Parser.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 结构数组(SoA)形式的紧凑语法树
+// 结点按后序存放(子结点总在父结点之前，根结点在最后)，每个结点只占几个定长整数，
+// 结点的属性不放在树里，由语义分析时的属性栈保存
+class CompactTree {
+public:
+	static constexpr uint32_t npos = 0xffffffffu;
+
+	// 追加一个叶子结点(终结符)，返回结点编号
+	uint32_t add_leaf(const Symbol& symbol);
+	// 追加一个内部结点，children 为已经追加过的子结点编号，production 为归约所用的产生式编号
+	uint32_t add_node(const Symbol& lhs, uint32_t production, const uint32_t* children, size_t count);
+
+	size_t size() const { return symbol_id.size(); }
+	bool empty() const { return symbol_id.empty(); }
+	uint32_t root() const { return static_cast<uint32_t>(size() - 1); }
+
+	uint32_t child(uint32_t node, uint32_t i) const { return child_index[first_child[node] + i]; }
+	const Symbol& symbol(uint32_t node) const { return symbols[symbol_id[node]]; }
+	std::string token_value(uint32_t node) const;
+
+	void clear();
+
+public:
+	std::vector<uint32_t> symbol_id;    // 结点的符号在 symbols 中的编号
+	std::vector<uint32_t> token_index;  // 叶子结点对应的 token 编号，内部结点为 npos
+	std::vector<uint32_t> production_id;  // 内部结点的产生式编号，叶子结点为 npos
+	std::vector<uint32_t> first_child;  // 子结点编号在 child_index 中的起始下标
+	std::vector<uint32_t> child_count;  // 子结点个数
+	std::vector<uint32_t> child_index;  // 所有结点的子结点编号，同一结点的子结点连续存放
+
+private:
+	uint32_t intern_symbol(const Symbol& symbol);
+
+private:
+	std::vector<Symbol> symbols;  // 树中出现过的符号(只保存类型和字面量)
+	std::unordered_map<std::string, uint32_t> symbol_ids;
+
+	// token 文本顺序拼接存放，第 i 个 token 为 token_text[token_offset[i], token_offset[i + 1])
+	std::string token_text;
+	std::vector<uint32_t> token_offset = {0};
+};
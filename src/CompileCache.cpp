@@ -0,0 +1,349 @@
+#include "CompileCache.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace {
+	// 编译器的输出(中间代码、变量表)或缓存文件格式变化时修改，使旧的缓存全部失效
+	const char* const compiler_version = "LR1Translator 5";
+
+	const char cache_magic[4] = {'L', 'R', '1', 'C'};
+
+	uint64_t mix(uint64_t x)
+	{
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ull;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebull;
+		x ^= x >> 31;
+		return x;
+	}
+
+	// 缓存文件只在本机使用，整数按本机字节序存放
+	void put_u64(std::string& buffer, uint64_t value) { buffer.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+	void put_u32(std::string& buffer, uint32_t value) { buffer.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+	void put_string(std::string& buffer, const std::string& value)
+	{
+		put_u32(buffer, static_cast<uint32_t>(value.size()));
+		buffer += value;
+	}
+
+	// 按写入的顺序读回，越界时 ok 置为 false
+	struct Reader
+	{
+		const std::string& data;
+		size_t position = 0;
+		bool ok = true;
+
+		template <typename T>
+		T get()
+		{
+			T value = 0;
+			if (data.size() - position < sizeof(T)) {
+				ok = false;
+				return value;
+			}
+			std::memcpy(&value, data.data() + position, sizeof(T));
+			position += sizeof(T);
+			return value;
+		}
+
+		std::string get_string()
+		{
+			uint32_t size = get<uint32_t>();
+			if (!ok || data.size() - position < size) {
+				ok = false;
+				return "";
+			}
+			std::string value = data.substr(position, size);
+			position += size;
+			return value;
+		}
+	};
+
+	// 名字、常量和复合操作数按编号顺序存放，读回时依次驻留即可得到相同的编号，四元式和变量的值直接存操作数
+	std::string encode(const CacheKey& key,
+	                   const std::vector<std::pair<size_t, Quater>>& code,
+	                   const std::map<std::string, VaribleMeta>& variables,
+	                   const Interner& names,
+	                   const std::vector<FunctionRange>& functions)
+	{
+		std::string buffer(cache_magic, sizeof(cache_magic));
+		put_u64(buffer, key.high);
+		put_u64(buffer, key.low);
+
+		put_u32(buffer, static_cast<uint32_t>(names.name_count()));
+		for (uint32_t i = 0; i < names.name_count(); ++i) {
+			put_string(buffer, names.name(i));
+		}
+		put_u32(buffer, static_cast<uint32_t>(names.constant_count()));
+		for (uint32_t i = 0; i < names.constant_count(); ++i) {
+			buffer += static_cast<char>(names.constant(i).kind);
+			put_string(buffer, names.constant(i).text);
+		}
+		put_u32(buffer, static_cast<uint32_t>(names.compound_count()));
+		for (uint32_t i = 0; i < names.compound_count(); ++i) {
+			buffer += static_cast<char>(names.compound(i).shape);
+			put_u32(buffer, names.compound(i).first.raw());
+			put_u32(buffer, names.compound(i).second.raw());
+		}
+
+		put_u32(buffer, static_cast<uint32_t>(variables.size()));
+		for (const auto& [name, meta] : variables) {
+			put_string(buffer, name);
+			put_string(buffer, meta.type);
+			put_u32(buffer, meta.value.raw());
+			buffer += static_cast<char>(meta.ambiguous);
+		}
+
+		put_u32(buffer, static_cast<uint32_t>(code.size()));
+		for (const auto& [id, quater] : code) {
+			put_u64(buffer, id);
+			buffer += static_cast<char>(quater.op);
+			put_u32(buffer, quater.arg1.raw());
+			put_u32(buffer, quater.arg2.raw());
+			put_u32(buffer, quater.result.raw());
+		}
+
+		put_u32(buffer, static_cast<uint32_t>(functions.size()));
+		for (const FunctionRange& function : functions) {
+			put_string(buffer, function.name);
+			put_u64(buffer, function.begin);
+			put_u64(buffer, function.end);
+		}
+		return buffer;
+	}
+
+	// 文件内容不可信：编号必须与驻留的顺序一致，操作数必须引用表中已有的名字、常量和复合操作数，
+	// 函数的范围必须依次排列在代码之内
+	bool decode(const std::string& data,
+	            const CacheKey& key,
+	            std::vector<std::pair<size_t, Quater>>& code,
+	            std::map<std::string, VaribleMeta>& variables,
+	            Interner& names,
+	            std::vector<FunctionRange>& functions)
+	{
+		if (data.size() < sizeof(cache_magic) || data.compare(0, sizeof(cache_magic), cache_magic, sizeof(cache_magic)) != 0) return false;
+		Reader reader{data, sizeof(cache_magic)};
+		if (reader.get<uint64_t>() != key.high || reader.get<uint64_t>() != key.low) return false;
+
+		uint32_t name_count = reader.get<uint32_t>();
+		for (uint32_t i = 0; i < name_count && reader.ok; ++i) {
+			if (names.variable(reader.get_string()).index() != i) return false;
+		}
+		uint32_t constant_count = reader.get<uint32_t>();
+		for (uint32_t i = 0; i < constant_count && reader.ok; ++i) {
+			auto kind = static_cast<Operand::Kind>(reader.get<uint8_t>());
+			std::string text = reader.get_string();
+			if (!Operand(kind, 0).is_constant()) return false;
+			if (names.constant(kind, text).index() != i) return false;
+		}
+		auto get_operand = [&]() {
+			Operand operand = Operand::from_raw(reader.get<uint32_t>());
+			if (!names.contains(operand)) reader.ok = false;
+			return operand;
+		};
+		uint32_t compound_count = reader.get<uint32_t>();
+		for (uint32_t i = 0; i < compound_count && reader.ok; ++i) {
+			uint8_t shape = reader.get<uint8_t>();
+			Operand first = get_operand();
+			Operand second = get_operand();
+			if (shape >= static_cast<uint8_t>(Compound::Shape::COUNT)) return false;
+			if (reader.ok && names.compound(static_cast<Compound::Shape>(shape), first, second).index() != i) return false;
+		}
+
+		uint32_t variable_count = reader.get<uint32_t>();
+		for (uint32_t i = 0; i < variable_count && reader.ok; ++i) {
+			std::string name = reader.get_string();
+			VaribleMeta meta;
+			meta.type = reader.get_string();
+			meta.value = get_operand();
+			meta.ambiguous = reader.get<uint8_t>() != 0;
+			variables.emplace(std::move(name), std::move(meta));
+		}
+
+		uint32_t code_count = reader.get<uint32_t>();
+		if (reader.ok) code.reserve(std::min<size_t>(code_count, data.size()));
+		for (uint32_t i = 0; i < code_count && reader.ok; ++i) {
+			uint64_t id = reader.get<uint64_t>();
+			uint8_t op = reader.get<uint8_t>();
+			if (op >= static_cast<uint8_t>(Opcode::COUNT)) return false;
+			Operand arg1 = get_operand();
+			Operand arg2 = get_operand();
+			Operand result = get_operand();
+			code.push_back({id, Quater(static_cast<Opcode>(op), arg1, arg2, result)});
+		}
+
+		uint32_t function_count = reader.get<uint32_t>();
+		for (uint32_t i = 0; i < function_count && reader.ok; ++i) {
+			FunctionRange function;
+			function.name = reader.get_string();
+			function.begin = reader.get<uint64_t>();
+			function.end = reader.get<uint64_t>();
+			size_t previous = functions.empty() ? 0 : functions.back().end;
+			if (function.begin < previous || function.end < function.begin || function.end > code.size()) return false;
+			functions.push_back(std::move(function));
+		}
+		return reader.ok && reader.position == data.size();
+	}
+}  // namespace
+
+std::string CacheKey::to_string() const
+{
+	static const char digits[] = "0123456789abcdef";
+	std::string text(32, '0');
+	for (int i = 0; i < 16; ++i) {
+		text[15 - i] = digits[(high >> (4 * i)) & 0xf];
+		text[31 - i] = digits[(low >> (4 * i)) & 0xf];
+	}
+	return text;
+}
+
+CacheKey hash_bytes(std::string_view data, const CacheKey& seed)
+{
+	// 两路初值和乘数不同的 FNV-1a，最后各自混合一次
+	uint64_t a = 0xcbf29ce484222325ull ^ seed.high;
+	uint64_t b = 0x84222325cbf29ce4ull ^ mix(seed.low);
+	for (unsigned char c : data) {
+		a = (a ^ c) * 0x100000001b3ull;
+		b = (b ^ c) * 0x9e3779b97f4a7c15ull;
+	}
+	CacheKey key;
+	key.high = mix(a ^ data.size());
+	key.low = mix(b + key.high);
+	return key;
+}
+
+CompileCache::CompileCache(const std::string& directory, uint64_t max_bytes, std::string_view tables)
+    : directory(directory), max_bytes(max_bytes)
+{
+	toolchain = hash_bytes(tables, hash_bytes(compiler_version));
+
+	namespace fs = std::filesystem;
+	std::error_code error;
+	fs::create_directories(directory, error);
+
+	// 按修改时间从旧到新登记已有的缓存文件，最新的排在最前
+	std::vector<std::pair<fs::file_time_type, Entry>> existing;
+	for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+		const fs::path& path = it->path();
+		std::error_code entry_error;
+		if (path.extension() != ".bin" || !it->is_regular_file(entry_error)) continue;
+		uint64_t size = it->file_size(entry_error);
+		fs::file_time_type time = it->last_write_time(entry_error);
+		if (!entry_error) existing.push_back({time, Entry{path.filename().string(), size}});
+	}
+	std::sort(existing.begin(), existing.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	std::lock_guard<std::mutex> lock(mutex);
+	for (const auto& [time, entry] : existing) {
+		touch(entry.name, entry.size);
+	}
+	evict();
+}
+
+CacheKey CompileCache::key(std::string_view source, uint32_t flags) const
+{
+	return hash_bytes(source, hash_bytes(std::to_string(flags), toolchain));
+}
+
+std::string CompileCache::path_of(const std::string& name) const
+{
+	return (std::filesystem::path(directory) / name).string();
+}
+
+bool CompileCache::lookup(const CacheKey& key,
+                          std::vector<std::pair<size_t, Quater>>& code,
+                          std::map<std::string, VaribleMeta>& variables,
+                          Interner& names,
+                          std::vector<FunctionRange>& functions)
+{
+	std::string name = key.to_string() + ".bin";
+	std::string path = path_of(name);
+	std::ifstream in(path, std::ios::binary);
+	if (!in) return false;
+	std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	in.close();
+
+	std::error_code error;
+	if (!decode(data, key, code, variables, names, functions)) {
+		// 文件损坏(例如写入时进程被杀)，删掉后重新编译
+		code.clear();
+		variables.clear();
+		names = Interner();
+		functions.clear();
+		std::filesystem::remove(path, error);
+		return false;
+	}
+
+	// 更新修改时间，其他进程启动时也能按最近使用的顺序淘汰
+	std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+	std::lock_guard<std::mutex> lock(mutex);
+	touch(name, data.size());
+	return true;
+}
+
+void CompileCache::store(const CacheKey& key,
+                         const std::vector<std::pair<size_t, Quater>>& code,
+                         const std::map<std::string, VaribleMeta>& variables,
+                         const Interner& names,
+                         const std::vector<FunctionRange>& functions)
+{
+	static std::atomic<uint64_t> counter{0};
+
+	std::string name = key.to_string() + ".bin";
+	std::string data = encode(key, code, variables, names, functions);
+
+	// 先写到临时文件再改名，读者不会看到写了一半的文件
+	std::string temporary = path_of(name) + "." +
+	                        std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "." +
+	                        std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "." +
+	                        std::to_string(counter++) + ".tmp";
+	std::error_code error;
+	std::ofstream out(temporary, std::ios::binary);
+	out.write(data.data(), data.size());
+	out.close();
+	if (!out) {
+		std::filesystem::remove(temporary, error);
+		return;
+	}
+	std::filesystem::rename(temporary, path_of(name), error);
+	if (error) {
+		std::filesystem::remove(temporary, error);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	touch(name, data.size());
+	evict();
+}
+
+void CompileCache::touch(const std::string& name, uint64_t size)
+{
+	auto it = entries.find(name);
+	if (it != entries.end()) {
+		total_bytes -= it->second->size;
+		recent.erase(it->second);
+	}
+	recent.push_front(Entry{name, size});
+	entries[name] = recent.begin();
+	total_bytes += size;
+}
+
+void CompileCache::evict()
+{
+	// 至少保留最近的一个结果
+	while (total_bytes > max_bytes && recent.size() > 1) {
+		const Entry& oldest = recent.back();
+		std::error_code error;
+		std::filesystem::remove(path_of(oldest.name), error);
+		total_bytes -= oldest.size;
+		entries.erase(oldest.name);
+		recent.pop_back();
+	}
+}
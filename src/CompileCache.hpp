@@ -0,0 +1,69 @@
+#pragma once
+
+#include "SemanticAnalyzer.hpp"
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 128 位内容哈希，作为缓存文件名
+struct CacheKey
+{
+	uint64_t high = 0;
+	uint64_t low = 0;
+
+	std::string to_string() const;  // 32 位十六进制
+};
+
+// 在 seed 的基础上继续哈希 data，用于把多个字段串起来计算一个键
+CacheKey hash_bytes(std::string_view data, const CacheKey& seed = CacheKey());
+
+// 磁盘上的编译缓存：以 (源代码, 分析表, 编译器版本, 编译选项) 的哈希为键，
+// 保存编译成功时的中间代码、变量表、其中的名字和常量以及各函数的范围(紧凑的二进制格式)，命中时跳过词法、语法和语义分析
+// 每个结果一个文件，写入时先写临时文件再改名，多个线程、多个进程可以共用一个缓存目录
+// 文件总大小超过上限时按最近使用时间(文件修改时间)淘汰最久未用的结果
+class CompileCache {
+public:
+	// directory 不存在时自动创建；tables 为分析表文件的内容
+	CompileCache(const std::string& directory, uint64_t max_bytes, std::string_view tables);
+
+	CacheKey key(std::string_view source, uint32_t flags) const;
+
+	bool lookup(const CacheKey& key,
+	            std::vector<std::pair<size_t, Quater>>& code,
+	            std::map<std::string, VaribleMeta>& variables,
+	            Interner& names,
+	            std::vector<FunctionRange>& functions);
+	void store(const CacheKey& key,
+	           const std::vector<std::pair<size_t, Quater>>& code,
+	           const std::map<std::string, VaribleMeta>& variables,
+	           const Interner& names,
+	           const std::vector<FunctionRange>& functions);
+
+private:
+	struct Entry
+	{
+		std::string name;  // 文件名(不含目录)
+		uint64_t size;
+	};
+
+	std::string path_of(const std::string& name) const;
+	// 把 name 记为最近使用，返回前需持有 mutex
+	void touch(const std::string& name, uint64_t size);
+	void evict();
+
+private:
+	std::string directory;
+	uint64_t max_bytes;
+	CacheKey toolchain;  // 分析表和编译器版本的哈希
+
+	std::mutex mutex;  // 保护下面的索引
+	std::list<Entry> recent;  // 最近使用的在前
+	std::unordered_map<std::string, std::list<Entry>::iterator> entries;
+	uint64_t total_bytes = 0;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "Arena.hpp"
+#include "LR1Parser.hpp"
+
+// 一次编译的上下文：语法树分配在 arena 中，上下文销毁时整棵树一起释放
+struct CompileContext
+{
+	Arena arena;
+	SemanticTreeNode* root = nullptr;
+};
@@ -0,0 +1,291 @@
+#include "CompileServer.hpp"
+#include <iostream>
+
+#ifdef _WIN32
+
+int run_compile_server(const std::string&, const CompileHandler&, size_t)
+{
+	std::cerr << "当前平台不支持编译服务" << std::endl;
+	return 1;
+}
+
+int run_compile_client(const std::string&, const std::string&, uint32_t, std::ostream&, std::ostream&)
+{
+	std::cerr << "当前平台不支持编译服务" << std::endl;
+	return 1;
+}
+
+#else
+
+#include "ThreadPool.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <pthread.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+	constexpr uint32_t max_request_size = 64u << 20;  // 源代码长度超过它的请求直接拒绝
+	constexpr int request_timeout_seconds = 10;        // 请求只发了一半就停下的客户端最多占用工作线程这么久
+
+	volatile std::sig_atomic_t stop_requested = 0;
+	volatile std::sig_atomic_t wake_fd = -1;  // 写入一个字节即可唤醒 accept 所在线程的 poll
+
+	void wake_server()
+	{
+		if (wake_fd >= 0 && ::write(wake_fd, "", 1) < 0) {
+			// 管道已满时已经有待处理的唤醒，忽略
+		}
+	}
+
+	void on_stop_signal(int)
+	{
+		stop_requested = 1;
+		wake_server();
+	}
+
+	bool read_all(int fd, void* data, size_t size)
+	{
+		char* p = static_cast<char*>(data);
+		while (size > 0) {
+			ssize_t n = ::read(fd, p, size);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			p += n;
+			size -= static_cast<size_t>(n);
+		}
+		return true;
+	}
+
+	bool write_all(int fd, const void* data, size_t size)
+	{
+		const char* p = static_cast<const char*>(data);
+		while (size > 0) {
+			// 客户端提前断开时不要因为 SIGPIPE 退出
+			ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			p += n;
+			size -= static_cast<size_t>(n);
+		}
+		return true;
+	}
+
+	bool read_u32(int fd, uint32_t& value)
+	{
+		unsigned char bytes[4];
+		if (!read_all(fd, bytes, 4)) return false;
+		value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+		return true;
+	}
+
+	bool write_u32(int fd, uint32_t value)
+	{
+		unsigned char bytes[4] = {static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+		                          static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24)};
+		return write_all(fd, bytes, 4);
+	}
+
+	bool write_string(int fd, const std::string& text)
+	{
+		return write_u32(fd, static_cast<uint32_t>(text.size())) && write_all(fd, text.data(), text.size());
+	}
+
+	bool read_string(int fd, std::string& text)
+	{
+		uint32_t length;
+		if (!read_u32(fd, length)) return false;
+		text.assign(length, '\0');
+		return read_all(fd, &text[0], length);
+	}
+
+	bool make_address(const std::string& socket_path, sockaddr_un& address)
+	{
+		std::memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if (socket_path.size() >= sizeof(address.sun_path)) {
+			std::cerr << "套接字路径过长: " << socket_path << std::endl;
+			return false;
+		}
+		std::strcpy(address.sun_path, socket_path.c_str());
+		return true;
+	}
+
+	// 处理连接上的一个请求；返回 false 表示客户端已经关闭连接或者出错，连接不能再用
+	bool serve_request(int fd, const CompileHandler& handler)
+	{
+		uint32_t flags, length;
+		if (!read_u32(fd, flags) || !read_u32(fd, length)) return false;
+		if (length > max_request_size) {
+			// 不读取请求体，回复错误后关闭连接
+			if (write_u32(fd, 1) && write_string(fd, "")) write_string(fd, "请求过大\n");
+			return false;
+		}
+		std::string source(length, '\0');
+		if (!read_all(fd, &source[0], length)) return false;
+
+		std::ostringstream out, diagnostics;
+		int code = handler(source, flags, out, diagnostics);
+		std::string output = out.str();
+		std::string messages = diagnostics.str();
+		return write_u32(fd, static_cast<uint32_t>(code)) && write_string(fd, output) && write_string(fd, messages);
+	}
+
+	bool set_nonblocking(int fd) { return ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK) == 0; }
+}  // namespace
+
+int run_compile_server(const std::string& socket_path, const CompileHandler& handler, size_t jobs)
+{
+	sockaddr_un address;
+	if (!make_address(socket_path, address)) return 1;
+
+	int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0) {
+		std::cerr << "创建套接字失败: " << std::strerror(errno) << std::endl;
+		return 1;
+	}
+	::unlink(socket_path.c_str());
+	if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(listener, 64) < 0) {
+		std::cerr << "监听 " << socket_path << " 失败: " << std::strerror(errno) << std::endl;
+		::close(listener);
+		return 1;
+	}
+
+	int wake_pipe[2];
+	if (::pipe(wake_pipe) < 0 || !set_nonblocking(wake_pipe[0]) || !set_nonblocking(wake_pipe[1])) {
+		std::cerr << "创建管道失败: " << std::strerror(errno) << std::endl;
+		::close(listener);
+		return 1;
+	}
+	wake_fd = wake_pipe[1];
+
+	// 信号处理函数写管道唤醒 poll，所以检查 stop_requested 和进入 poll 之间收到信号也不会丢失
+	struct sigaction action;
+	std::memset(&action, 0, sizeof(action));
+	action.sa_handler = on_stop_signal;
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+
+	// 空闲的连接由本线程 poll，有请求到达时才交给线程池，每个任务只处理一个请求；
+	// 处理完的连接放进 returned 再交还给本线程，所以空闲的客户端不占用工作线程
+	std::vector<int> idle;
+	std::mutex returned_mutex;
+	std::vector<int> returned;
+
+	std::cerr << "编译服务已启动: " << socket_path << std::endl;
+	{
+		// 工作线程屏蔽停止信号，保证信号总是送到本线程
+		sigset_t stop_signals, previous;
+		sigemptyset(&stop_signals);
+		sigaddset(&stop_signals, SIGINT);
+		sigaddset(&stop_signals, SIGTERM);
+		pthread_sigmask(SIG_BLOCK, &stop_signals, &previous);
+		ThreadPool pool(jobs);
+		pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+		std::vector<pollfd> fds;
+		while (!stop_requested) {
+			fds.clear();
+			fds.push_back({wake_pipe[0], POLLIN, 0});
+			fds.push_back({listener, POLLIN, 0});
+			for (int connection : idle) fds.push_back({connection, POLLIN, 0});
+
+			if (::poll(fds.data(), fds.size(), -1) < 0) {
+				if (errno == EINTR) continue;
+				std::cerr << "poll 失败: " << std::strerror(errno) << std::endl;
+				break;
+			}
+
+			// 有请求的连接移出 idle 交给线程池，先处理它们，再加入新的连接
+			size_t kept = 0;
+			for (size_t i = 0; i < idle.size(); ++i) {
+				int connection = idle[i];
+				if (fds[i + 2].revents == 0) {
+					idle[kept++] = connection;
+					continue;
+				}
+				pool.submit([connection, &handler, &returned_mutex, &returned]() {
+					if (!serve_request(connection, handler)) {
+						::close(connection);
+						return;
+					}
+					std::lock_guard<std::mutex> lock(returned_mutex);
+					returned.push_back(connection);
+					wake_server();
+				});
+			}
+			idle.resize(kept);
+
+			if (fds[0].revents != 0) {
+				char drain[64];
+				while (::read(wake_pipe[0], drain, sizeof(drain)) > 0) {}
+				std::lock_guard<std::mutex> lock(returned_mutex);
+				idle.insert(idle.end(), returned.begin(), returned.end());
+				returned.clear();
+			}
+
+			if (fds[1].revents != 0) {
+				int connection = ::accept(listener, nullptr, nullptr);
+				if (connection < 0) {
+					if (errno == EINTR || errno == ECONNABORTED) continue;
+					std::cerr << "accept 失败: " << std::strerror(errno) << std::endl;
+					break;
+				}
+				timeval timeout{request_timeout_seconds, 0};
+				::setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+				idle.push_back(connection);
+			}
+		}
+		// 析构时等待正在处理的请求完成
+	}
+
+	for (int connection : idle) ::close(connection);
+	for (int connection : returned) ::close(connection);
+	wake_fd = -1;
+	::close(wake_pipe[0]);
+	::close(wake_pipe[1]);
+	::close(listener);
+	::unlink(socket_path.c_str());
+	std::cerr << "编译服务已停止" << std::endl;
+	return 0;
+}
+
+int run_compile_client(const std::string& socket_path,
+                       const std::string& source,
+                       uint32_t flags,
+                       std::ostream& out,
+                       std::ostream& diagnostics)
+{
+	sockaddr_un address;
+	if (!make_address(socket_path, address)) return 1;
+
+	int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+		std::cerr << "无法连接编译服务 " << socket_path << ": " << std::strerror(errno) << std::endl;
+		if (fd >= 0) ::close(fd);
+		return 1;
+	}
+
+	uint32_t code = 1;
+	std::string output, messages;
+	bool ok = write_u32(fd, flags) && write_string(fd, source) && read_u32(fd, code) && read_string(fd, output) &&
+	          read_string(fd, messages);
+	::close(fd);
+
+	if (!ok) {
+		std::cerr << "与编译服务通信失败" << std::endl;
+		return 1;
+	}
+	out << output;
+	diagnostics << messages;
+	return static_cast<int32_t>(code);
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+// 编译服务：常驻进程只加载一次分析表，在 Unix 域套接字上接收编译请求，由线程池中的工作线程处理
+//
+// 协议(整数均为小端 32 位)：
+//   请求：flags, 源代码长度, 源代码
+//   响应：退出码, 输出长度, 输出, 诊断信息长度, 诊断信息
+//   输出和诊断信息分别与命令行编译时写到标准输出、标准错误的内容相同
+// 一个连接上可以依次发送多个请求，客户端关闭连接即结束
+// 源代码长度超过 64MB 的请求不予处理，回复退出码 1 后关闭连接
+
+// 请求中的选项
+enum CompileRequestFlags : uint32_t
+{
+	REQUEST_COMPACT_TREE = 1u << 0,
+	REQUEST_TRANSLATE_ON_REDUCE = 1u << 1,
+	REQUEST_PIPELINE = 1u << 2,
+	REQUEST_REUSE_TEMPS = 1u << 3,
+	REQUEST_OPTIMIZE = 1u << 4,
+};
+
+// 编译一份源代码，结果写到 out，错误信息写到 diagnostics，返回退出码；会在多个工作线程中同时调用
+using CompileHandler =
+    std::function<int(const std::string& source, uint32_t flags, std::ostream& out, std::ostream& diagnostics)>;
+
+// 在 socket_path 上监听，直到收到 SIGINT/SIGTERM；返回进程退出码
+int run_compile_server(const std::string& socket_path, const CompileHandler& handler, size_t jobs);
+
+// 把源代码发给服务端编译，输出写到 out，诊断信息写到 diagnostics，返回服务端给出的退出码；连接失败返回 1
+int run_compile_client(const std::string& socket_path,
+                       const std::string& source,
+                       uint32_t flags,
+                       std::ostream& out,
+                       std::ostream& diagnostics);
@@ -0,0 +1,76 @@
+#include "Compiler.hpp"
+#include "CompileContext.hpp"
+#include "Lexer.hpp"
+#include "ParseStats.hpp"
+#include <sstream>
+
+namespace {
+	// 按行拆分错误信息，忽略空行
+	void append_lines(const std::string& text, std::vector<std::string>& lines)
+	{
+		size_t begin = 0;
+		while (begin < text.size()) {
+			size_t end = text.find('\n', begin);
+			if (end == std::string::npos) end = text.size();
+			if (end > begin) lines.emplace_back(text, begin, end - begin);
+			begin = end + 1;
+		}
+	}
+
+	// 在作用域内把本线程的词法、语法错误输出重定向到 out，退出时恢复默认输出
+	class ErrorCapture {
+	public:
+		explicit ErrorCapture(std::ostream& out)
+		{
+			Lexer::set_error_output(&out);
+			LR1Parser::set_error_output(&out);
+		}
+		~ErrorCapture()
+		{
+			Lexer::set_error_output(nullptr);
+			LR1Parser::set_error_output(nullptr);
+		}
+
+		ErrorCapture(const ErrorCapture&) = delete;
+		ErrorCapture& operator=(const ErrorCapture&) = delete;
+	};
+}  // namespace
+
+bool load_tables(const std::string& file_path, Tables& tables)
+{
+	return tables.load_tables(file_path);
+}
+
+CompileResult compile(std::string_view source, const Tables& tables)
+{
+	CompileResult result;
+	std::ostringstream errors;
+	ErrorCapture capture(errors);
+
+	Lexer lexer{std::string(source)};
+	TokenSource next_token = [&lexer]() {
+		Token token = lexer.getNextToken();
+		return Symbol(SymbolType::Terminal, token.type_to_string(), token.value);
+	};
+
+	CompileContext context;
+	SemanticAnalyzer analyzer(context.root, tables.get_productions());
+	try {
+		if (!tables.parse(next_token, context.root, context.arena)) {
+			result.status = 1;
+		} else {
+			PARSE_STATS_PHASE("semantic");
+			analyzer.semantic_analyze();
+			result.code = analyzer.get_intermediate_code();
+			result.variables = analyzer.get_variable_table();
+			result.names = analyzer.get_interner();
+		}
+	} catch (const SemanticError& error) {
+		errors << error.what() << '\n';
+		result.status = -1;
+	}
+
+	append_lines(errors.str(), result.diagnostics);
+	PARSE_STATS_FLUSH();
+	return result;
+}
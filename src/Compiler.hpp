@@ -0,0 +1,31 @@
+#pragma once
+
+#include "LR1Parser.hpp"
+#include "SemanticAnalyzer.hpp"
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// 进程内的编译接口：源代码从内存读入，结果以结构化数据返回，
+// 不读写标准输入输出，也不会退出进程，可以在测试程序中反复调用
+
+// 分析表：加载好 ACTION/GOTO 表的语法分析器，编译时只读，多个线程可以共用同一份
+using Tables = LR1Parser;
+
+struct CompileResult
+{
+	int status = 0;  // 0 成功，1 语法错误，-1 语义错误，与命令行的返回值一致
+	std::vector<std::pair<size_t, Quater>> code;   // 中间代码
+	std::map<std::string, VaribleMeta> variables;  // 变量表
+	Interner names;                                // code 和 variables 中操作数引用的名字和常量
+	std::vector<std::string> diagnostics;          // 词法、语法和语义错误信息，每条一行
+
+	bool ok() const { return status == 0; }
+};
+
+// 从文件加载分析表，文件打不开时返回 false
+bool load_tables(const std::string& file_path, Tables& tables);
+
+CompileResult compile(std::string_view source, const Tables& tables);
@@ -0,0 +1,91 @@
+#include "IRBuffer.hpp"
+
+Operand IRBuffer::relative_label(int64_t offset)
+{
+	// 偏移可能为负(向后跳)，按 28 位补码存放在标号的编号中，超出范围时报错
+	const int64_t limit = int64_t{1} << 27;
+	if (offset < -limit || offset >= limit) {
+		throw std::length_error("Jump offset exceeds 28 bits: " + std::to_string(offset));
+	}
+	return Operand::label(static_cast<uint32_t>(offset) & Operand::max_index);
+}
+
+int32_t IRBuffer::offset_of(Operand label)
+{
+	return static_cast<int32_t>(label.index() << 4) >> 4;
+}
+
+uint32_t IRBuffer::new_segment(uint32_t begin, uint32_t end)
+{
+	segments.push_back(Segment{begin, end});
+	return static_cast<uint32_t>(segments.size() - 1);
+}
+
+uint32_t IRBuffer::emit(IRCode& code, const Quater& quater)
+{
+	uint32_t index = static_cast<uint32_t>(quads.size());
+	quads.push_back(quater);
+
+	// 子结点的段可能被增量分析复用，只延长本结点自己的段
+	if (code.owns_tail && segments[code.tail].end == index) {
+		++segments[code.tail].end;
+	} else {
+		uint32_t segment = new_segment(index, index + 1);
+		if (code.empty()) {
+			code.head = segment;
+		} else {
+			segments[code.tail].next = segment;
+		}
+		code.tail = segment;
+		code.owns_tail = true;
+	}
+	++code.size;
+	return index;
+}
+
+void IRBuffer::append(IRCode& code, const IRCode& other)
+{
+	if (other.empty()) return;
+	if (code.empty()) {
+		code.head = other.head;
+	} else {
+		segments[code.tail].next = other.head;
+	}
+	code.tail = other.tail;
+	code.size += other.size;
+	code.owns_tail = false;
+}
+
+void IRBuffer::emit_jump(IRCode& code, Opcode op, Operand condition, JumpList& list)
+{
+	uint32_t position = code.size;
+	list.push_back({emit(code, Quater(op, condition, Operand(), Operand())), position});
+}
+
+void IRBuffer::emit_jump(IRCode& code, Opcode op, Operand condition, uint32_t target)
+{
+	uint32_t position = code.size;
+	emit(code, Quater(op, condition, Operand(), relative_label(static_cast<int64_t>(target) - position)));
+}
+
+void IRBuffer::backpatch(const JumpList& list, uint32_t target)
+{
+	for (const PendingJump& jump : list) {
+		quads[jump.quad].result = relative_label(static_cast<int64_t>(target) - jump.position);
+	}
+}
+
+std::vector<std::pair<size_t, Quater>> IRBuffer::flatten(const IRCode& code, size_t first_id) const
+{
+	std::vector<std::pair<size_t, Quater>> result;
+	result.reserve(code.size);
+	for_each_segment(code, [&](const Segment& segment) {
+		for (uint32_t i = segment.begin; i < segment.end; ++i) {
+			size_t id = first_id + result.size();
+			Quater quater = quads[i];
+			if (quater.is_jump()) quater.result = Operand::label(id + offset_of(quater.result));
+			result.push_back({id, quater});
+		}
+	});
+	return result;
+}
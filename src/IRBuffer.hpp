@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Quater.hpp"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// 一个结点的中间代码：IRBuffer 中若干段 [begin, end) 组成的链表，按链表顺序就是代码的排列顺序
+// 父结点合并子结点的代码时只连接链表，不复制四元式
+struct IRCode
+{
+	static constexpr uint32_t none = UINT32_MAX;
+
+	uint32_t head = none;  // 第一段和最后一段在 IRBuffer 中的下标
+	uint32_t tail = none;
+	uint32_t size = 0;         // 四元式总数，也是下一条四元式在本结点代码中的相对编号
+	bool owns_tail = false;    // 最后一段是本结点自己生成的，可以直接延长
+
+	bool empty() const { return size == 0; }
+};
+
+// 目标还未确定的跳转：四元式在缓冲区中的下标，以及它在所属结点代码中的相对编号
+struct PendingJump
+{
+	uint32_t quad;
+	uint32_t position;
+};
+using JumpList = std::vector<PendingJump>;
+
+// 只追加的中间代码缓冲区：每条四元式生成时写入一次，之后不再复制
+// 生成期间跳转目标保存为相对于跳转本身的偏移，代码块整体移动时不必修改；
+// flatten 按链表顺序给四元式编号时再换成绝对编号
+class IRBuffer {
+public:
+	// 在 code 末尾生成一条四元式，返回它在缓冲区中的下标
+	uint32_t emit(IRCode& code, const Quater& quater);
+	// 把 other 接到 code 后面
+	void append(IRCode& code, const IRCode& other);
+
+	// 生成目标待定的跳转，记入 list，确定目标后用 backpatch 回填
+	void emit_jump(IRCode& code, Opcode op, Operand condition, JumpList& list);
+	// 生成目标已知的跳转(向后跳)，target 为 code 中的相对编号
+	void emit_jump(IRCode& code, Opcode op, Operand condition, uint32_t target);
+	// 把 list 中的跳转目标填为 target(code 中的相对编号，通常是 code.size)
+	void backpatch(const JumpList& list, uint32_t target);
+
+	// 按排列顺序从 first_id 开始编号，得到最终的中间代码
+	std::vector<std::pair<size_t, Quater>> flatten(const IRCode& code, size_t first_id = 0) const;
+	// 丢掉所有四元式(保留已申请的内存)，之前生成的 IRCode 全部失效
+	void clear()
+	{
+		quads.clear();
+		segments.clear();
+	}
+
+	// 按排列顺序修改 code 中的每条四元式
+	template <typename Function>
+	void update(const IRCode& code, Function function)
+	{
+		for_each_segment(code, [&](const Segment& segment) {
+			for (uint32_t i = segment.begin; i < segment.end; ++i) function(quads[i]);
+		});
+	}
+	// 把另一个缓冲区中的 code 按排列顺序复制为本缓冲区中连续的一段，复制时用 function 改写每条四元式
+	template <typename Function>
+	IRCode import(const IRBuffer& other, const IRCode& code, Function function)
+	{
+		IRCode result;
+		if (code.empty()) return result;
+		uint32_t begin = static_cast<uint32_t>(quads.size());
+		other.for_each_segment(code, [&](const Segment& segment) {
+			for (uint32_t i = segment.begin; i < segment.end; ++i) {
+				quads.push_back(other.quads[i]);
+				function(quads.back());
+			}
+		});
+		result.head = result.tail = new_segment(begin, static_cast<uint32_t>(quads.size()));
+		result.size = code.size;
+		return result;
+	}
+
+private:
+	struct Segment
+	{
+		uint32_t begin;
+		uint32_t end;
+		uint32_t next = IRCode::none;
+	};
+
+	uint32_t new_segment(uint32_t begin, uint32_t end);
+
+	// 链表可能被复用的子树接到别处，尾部的 next 不一定为空，因此遍历到 tail 为止
+	template <typename Function>
+	void for_each_segment(const IRCode& code, Function function) const
+	{
+		if (code.empty()) return;
+		for (uint32_t index = code.head;; index = segments[index].next) {
+			function(segments[index]);
+			if (index == code.tail) break;
+		}
+	}
+
+	static Operand relative_label(int64_t offset);
+	static int32_t offset_of(Operand label);
+
+private:
+	std::vector<Quater> quads;
+	std::vector<Segment> segments;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+
+// 二进制中间代码文件(--emit=ir-bin)的格式：IRWriter 写出，IRReader 映射到内存后直接按下面的结构读取，不需要解析
+// 文件由若干块组成，每块以 IRChunkHeader 开头，后面是块内的各个数组；数组都按 8 字节对齐，偏移相对于块的开头
+// 一次写出的文件只有一块；按函数流式写出时每个函数(以及函数之间的代码)一块，变量表在最后一块
+// 四元式、名字、常量和复合操作数在整个文件中连续编号，每块只保存上一块之后新增的部分，从各自的 base 开始编号
+// 整数按写出时的本机字节序存放，读取时用 byte_order 检查字节序是否一致
+
+constexpr char ir_magic[4] = {'L', 'R', '1', 'I'};
+constexpr uint32_t ir_version = 1;
+constexpr uint32_t ir_byte_order = 0x01020304;
+constexpr uint32_t ir_chunk_last = 1u << 0;  // 文件的最后一块
+
+// 块内字符串池中的一段文本
+struct IRString
+{
+	uint32_t offset;
+	uint32_t size;
+};
+
+// 块内的一个数组：开始位置相对于块开头的偏移，以及元素个数(字符串池为字节数)
+struct IRArray
+{
+	uint32_t offset;
+	uint32_t count;
+};
+
+// 四元式，操作数为 Operand::raw()：高 4 位为种类，低 28 位为编号；跳转目标是四元式在整个文件中的编号
+struct IRQuad
+{
+	uint8_t op;  // Opcode
+	uint8_t reserved[3];
+	uint32_t arg1;
+	uint32_t arg2;
+	uint32_t result;
+};
+
+struct IRConstant
+{
+	uint8_t kind;  // Operand::Kind
+	uint8_t reserved[3];
+	IRString text;  // 源代码中的写法
+	uint32_t reserved2;
+	int64_t integer;  // 整数和字符常量的值
+	double real;      // 浮点常量的值
+};
+
+// 复合操作数：shape 为 Compound::Shape(0 调用、1 数组元素、2 实参列表)
+struct IRCompound
+{
+	uint8_t shape;
+	uint8_t reserved[3];
+	uint32_t first;
+	uint32_t second;
+};
+
+struct IRVariable
+{
+	IRString name;
+	IRString type;
+	uint32_t value;  // 初始值，没有时为 0
+	uint32_t reserved;
+};
+
+// 一个函数的代码 [begin, end)
+struct IRFunction
+{
+	IRString name;
+	uint32_t begin;
+	uint32_t end;
+};
+
+struct IRChunkHeader
+{
+	char magic[4];
+	uint32_t byte_order;
+	uint32_t version;
+	uint32_t flags;
+	uint64_t size;  // 整块的字节数(包括本结构)，下一块紧接在后面
+
+	uint32_t quad_base;
+	uint32_t name_base;
+	uint32_t constant_base;
+	uint32_t compound_base;
+
+	IRArray quads;
+	IRArray names;  // IRString
+	IRArray constants;
+	IRArray compounds;
+	IRArray variables;
+	IRArray functions;
+	IRArray strings;
+};
+
+static_assert(sizeof(IRQuad) == 16 && sizeof(IRConstant) == 32 && sizeof(IRCompound) == 12, "记录大小与文件格式不一致");
+static_assert(sizeof(IRVariable) == 24 && sizeof(IRFunction) == 16 && sizeof(IRChunkHeader) == 96, "记录大小与文件格式不一致");
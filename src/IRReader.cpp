@@ -0,0 +1,226 @@
+#include "IRReader.hpp"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	// 数组 array 的 count 个记录是否都在长度为 size 的块内
+	bool fits(const IRArray& array, size_t record_size, uint64_t size)
+	{
+		return array.offset % 8 == 0 && array.offset <= size && (size - array.offset) / record_size >= array.count;
+	}
+}  // namespace
+
+IRReader::~IRReader()
+{
+	close();
+}
+
+bool IRReader::open(const std::string& path)
+{
+	close();
+#ifdef _WIN32
+	std::ifstream in(path, std::ios::binary);
+	if (!in) return false;
+	std::vector<char> content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	if (!open(content.data(), content.size())) return false;
+	copy = std::move(content);  // vector 移动后元素仍在原来的位置，data 继续有效
+	return true;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return false;
+	struct stat info;
+	void* address = MAP_FAILED;
+	if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+		address = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	::close(fd);
+	if (address == MAP_FAILED) return false;
+
+	if (!open(address, info.st_size)) {
+		::munmap(address, info.st_size);
+		return false;
+	}
+	mapped = true;
+	return true;
+#endif
+}
+
+bool IRReader::open(const void* file, size_t file_size)
+{
+	close();
+	data = static_cast<const char*>(file);
+	size = file_size;
+	if (reinterpret_cast<uintptr_t>(data) % 8 != 0) {
+		close();
+		return false;
+	}
+
+	// 依次检查每一块：块头、各数组的范围，以及编号是否接着上一块
+	bool last = false;
+	for (size_t position = 0; position < size && !last;) {
+		if (size - position < sizeof(IRChunkHeader)) break;
+		const char* chunk = data + position;
+		const IRChunkHeader& header = *reinterpret_cast<const IRChunkHeader*>(chunk);
+		bool valid = std::memcmp(header.magic, ir_magic, sizeof(ir_magic)) == 0 && header.byte_order == ir_byte_order &&
+		             header.version == ir_version && header.size >= sizeof(IRChunkHeader) && header.size % 8 == 0 &&
+		             header.size <= size - position;
+		valid = valid && fits(header.quads, sizeof(IRQuad), header.size) && fits(header.names, sizeof(IRString), header.size) &&
+		        fits(header.constants, sizeof(IRConstant), header.size) && fits(header.compounds, sizeof(IRCompound), header.size) &&
+		        fits(header.variables, sizeof(IRVariable), header.size) && fits(header.functions, sizeof(IRFunction), header.size) &&
+		        fits(header.strings, 1, header.size);
+		valid = valid && header.quad_base == quad_total && header.name_base == name_total &&
+		        header.constant_base == constant_total && header.compound_base == compound_total;
+		if (!valid) break;
+
+		std::string_view strings(chunk + header.strings.offset, header.strings.count);
+		auto add = [&](std::vector<Section>& sections, const IRArray& array, uint32_t base, size_t& total) {
+			if (array.count > 0) sections.push_back(Section{base, array.count, chunk + array.offset, strings});
+			total += array.count;
+		};
+		add(quads, header.quads, header.quad_base, quad_total);
+		add(names, header.names, header.name_base, name_total);
+		add(constants, header.constants, header.constant_base, constant_total);
+		add(compounds, header.compounds, header.compound_base, compound_total);
+		for (uint32_t i = 0; i < header.variables.count; ++i) {
+			variables.push_back({reinterpret_cast<const IRVariable*>(chunk + header.variables.offset) + i, strings});
+		}
+		for (uint32_t i = 0; i < header.functions.count; ++i) {
+			functions.push_back({reinterpret_cast<const IRFunction*>(chunk + header.functions.offset) + i, strings});
+		}
+
+		last = header.flags & ir_chunk_last;
+		position += header.size;
+		if (last && position != size) last = false;
+	}
+
+	// 流式写出时中途停止的文件没有最后一块
+	bool valid = last;
+	for (const auto& [function, strings] : functions) {
+		if (function->begin > function->end || function->end > quad_total) valid = false;
+	}
+	if (!valid) close();
+	return valid;
+}
+
+void IRReader::close()
+{
+#ifndef _WIN32
+	if (mapped) ::munmap(const_cast<char*>(data), size);
+#endif
+	data = nullptr;
+	size = 0;
+	mapped = false;
+	copy.clear();
+	quads.clear();
+	names.clear();
+	constants.clear();
+	compounds.clear();
+	variables.clear();
+	functions.clear();
+	quad_total = name_total = constant_total = compound_total = 0;
+}
+
+template <typename Record>
+const Record* IRReader::find(const std::vector<Section>& sections, uint32_t id, std::string_view& strings) const
+{
+	auto it = std::upper_bound(sections.begin(), sections.end(), id, [](uint32_t value, const Section& section) { return value < section.base; });
+	if (it == sections.begin()) return nullptr;
+	--it;
+	if (id - it->base >= it->count) return nullptr;
+	strings = it->strings;
+	return reinterpret_cast<const Record*>(it->records) + (id - it->base);
+}
+
+std::string_view IRReader::text(std::string_view strings, IRString string)
+{
+	if (string.offset > strings.size() || strings.size() - string.offset < string.size) return std::string_view();
+	return strings.substr(string.offset, string.size);
+}
+
+Quater IRReader::quad(size_t index) const
+{
+	std::string_view strings;
+	const IRQuad* record = index < quad_total ? find<IRQuad>(quads, static_cast<uint32_t>(index), strings) : nullptr;
+	if (record == nullptr || record->op >= static_cast<uint8_t>(Opcode::COUNT)) return Quater(Opcode::JUMP, Operand(), Operand(), Operand());
+	return Quater(static_cast<Opcode>(record->op), Operand::from_raw(record->arg1), Operand::from_raw(record->arg2), Operand::from_raw(record->result));
+}
+
+std::string_view IRReader::name(uint32_t id) const
+{
+	std::string_view strings;
+	const IRString* record = find<IRString>(names, id, strings);
+	return record != nullptr ? text(strings, *record) : std::string_view();
+}
+
+IRReader::ConstantView IRReader::constant(uint32_t id) const
+{
+	std::string_view strings;
+	const IRConstant* record = find<IRConstant>(constants, id, strings);
+	if (record == nullptr) return ConstantView{Operand::Kind::NONE, std::string_view(), 0, 0};
+	return ConstantView{static_cast<Operand::Kind>(record->kind), text(strings, record->text), record->integer, record->real};
+}
+
+IRReader::CompoundView IRReader::compound(uint32_t id) const
+{
+	std::string_view strings;
+	const IRCompound* record = find<IRCompound>(compounds, id, strings);
+	if (record == nullptr) return CompoundView{0, Operand(), Operand()};
+	return CompoundView{record->shape, Operand::from_raw(record->first), Operand::from_raw(record->second)};
+}
+
+IRReader::VariableView IRReader::variable(size_t index) const
+{
+	if (index >= variables.size()) return VariableView{std::string_view(), std::string_view(), Operand()};
+	const auto& [record, strings] = variables[index];
+	return VariableView{text(strings, record->name), text(strings, record->type), Operand::from_raw(record->value)};
+}
+
+IRReader::FunctionView IRReader::function(size_t index) const
+{
+	if (index >= functions.size()) return FunctionView{std::string_view(), 0, 0};
+	const auto& [record, strings] = functions[index];
+	return FunctionView{text(strings, record->name), record->begin, record->end};
+}
+
+std::string IRReader::to_string(Operand operand) const
+{
+	switch (operand.kind()) {
+	case Operand::Kind::NONE:
+		return "";
+	case Operand::Kind::VARIABLE:
+		return std::string(name(operand.index()));
+	case Operand::Kind::TEMP:
+		return "t" + std::to_string(operand.index());
+	case Operand::Kind::LABEL:
+		return std::to_string(operand.index());
+	case Operand::Kind::COMPOUND: {
+		// 复合操作数只引用编号更小的复合操作数，文件损坏时也不会无限递归
+		CompoundView part = compound(operand.index());
+		auto inner = [&](Operand child) {
+			return child.kind() == Operand::Kind::COMPOUND && child.index() >= operand.index() ? std::string() : to_string(child);
+		};
+		if (part.shape == 0) return inner(part.first) + "(" + inner(part.second) + ")";
+		if (part.shape == 1) return inner(part.first) + "[" + inner(part.second) + "]";
+		return inner(part.first) + "," + inner(part.second);
+	}
+	default:
+		return std::string(constant(operand.index()).text);
+	}
+}
+
+std::string IRReader::to_string(const Quater& quater) const
+{
+	std::string arg1 = quater.arg1.empty() ? "_" : to_string(quater.arg1);
+	std::string arg2 = quater.arg2.empty() ? "_" : to_string(quater.arg2);
+	return std::string("(") + opcode_name(quater.op) + ", " + arg1 + ", " + arg2 + ", " + to_string(quater.result) + ")";
+}
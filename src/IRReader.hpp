@@ -0,0 +1,107 @@
+#pragma once
+
+#include "IRFormat.hpp"
+#include "Quater.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// 读取二进制中间代码文件(--emit=ir-bin)的小型库，只依赖 IRFormat.hpp 和 Quater.hpp
+// 文件映射到内存后只检查各块的结构，四元式、名字和常量都直接从映射的内容中取，不复制也不解析
+// 编号与编译器中的一致：四元式按文件中的顺序从 0 开始，操作数直接用 Operand 表示
+class IRReader {
+public:
+	struct ConstantView
+	{
+		Operand::Kind kind;
+		std::string_view text;
+		int64_t integer;
+		double real;
+	};
+
+	struct CompoundView
+	{
+		uint8_t shape;  // 0 调用 first(second)，1 数组元素 first[second]，2 实参列表 first,second
+		Operand first;
+		Operand second;
+	};
+
+	struct VariableView
+	{
+		std::string_view name;
+		std::string_view type;
+		Operand value;  // 没有初始值时为空
+	};
+
+	struct FunctionView
+	{
+		std::string_view name;
+		uint32_t begin;
+		uint32_t end;
+	};
+
+	IRReader() = default;
+	~IRReader();
+
+	IRReader(const IRReader&) = delete;
+	IRReader& operator=(const IRReader&) = delete;
+
+	// 映射 path 并检查格式，文件不存在或格式不对时返回 false
+	bool open(const std::string& path);
+	// 直接读取内存中的文件内容(例如 encode_ir 的结果)，data 需按 8 字节对齐，读取期间保持有效
+	bool open(const void* data, size_t size);
+	void close();
+
+	size_t quad_count() const { return quad_total; }
+	size_t name_count() const { return name_total; }
+	size_t constant_count() const { return constant_total; }
+	size_t compound_count() const { return compound_total; }
+	size_t variable_count() const { return variables.size(); }
+	size_t function_count() const { return functions.size(); }
+
+	// 编号越界时返回空的四元式、空文本
+	Quater quad(size_t index) const;
+	std::string_view name(uint32_t id) const;
+	ConstantView constant(uint32_t id) const;
+	CompoundView compound(uint32_t id) const;
+	VariableView variable(size_t index) const;
+	FunctionView function(size_t index) const;
+
+	// 与编译器输出中相同的写法，例如 t3、'a'、(+, a, 1, t0)
+	std::string to_string(Operand operand) const;
+	std::string to_string(const Quater& quater) const;
+
+private:
+	// 某一块中的一个数组，编号从 base 开始
+	struct Section
+	{
+		uint32_t base;
+		uint32_t count;
+		const char* records;
+		std::string_view strings;  // 所在块的字符串池
+	};
+
+	// 按编号找到所在的数组和其中的记录
+	template <typename Record>
+	const Record* find(const std::vector<Section>& sections, uint32_t id, std::string_view& strings) const;
+	static std::string_view text(std::string_view strings, IRString string);
+
+private:
+	const char* data = nullptr;
+	size_t size = 0;
+	bool mapped = false;  // data 是 open(path) 映射的，close 时解除映射
+	std::vector<char> copy;  // 不能映射文件的平台上读入的内容
+
+	std::vector<Section> quads;
+	std::vector<Section> names;
+	std::vector<Section> constants;
+	std::vector<Section> compounds;
+	std::vector<std::pair<const IRVariable*, std::string_view>> variables;
+	std::vector<std::pair<const IRFunction*, std::string_view>> functions;
+	size_t quad_total = 0;
+	size_t name_total = 0;
+	size_t constant_total = 0;
+	size_t compound_total = 0;
+};
@@ -0,0 +1,202 @@
+#include "IRWriter.hpp"
+#include <cstring>
+
+namespace {
+	// 一块的内容：开头先留出块头的位置，各数组依次追加并对齐到 8 字节，最后填好块头
+	class ChunkBuilder {
+	public:
+		IRChunkHeader header{};
+
+		ChunkBuilder() : buffer(sizeof(IRChunkHeader), '\0') {}
+
+		template <typename T>
+		IRArray add(const std::vector<T>& items)
+		{
+			align();
+			IRArray array{static_cast<uint32_t>(buffer.size()), static_cast<uint32_t>(items.size())};
+			buffer.append(reinterpret_cast<const char*>(items.data()), items.size() * sizeof(T));
+			return array;
+		}
+
+		IRString add_string(const std::string& text)
+		{
+			IRString string{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(text.size())};
+			strings += text;
+			return string;
+		}
+
+		std::string finish(uint32_t flags)
+		{
+			align();
+			header.strings = {static_cast<uint32_t>(buffer.size()), static_cast<uint32_t>(strings.size())};
+			buffer += strings;
+			align();
+
+			std::memcpy(header.magic, ir_magic, sizeof(ir_magic));
+			header.byte_order = ir_byte_order;
+			header.version = ir_version;
+			header.flags = flags;
+			header.size = buffer.size();
+			std::memcpy(&buffer[0], &header, sizeof(header));
+			return std::move(buffer);
+		}
+
+	private:
+		void align() { buffer.resize((buffer.size() + 7) / 8 * 8, '\0'); }
+
+		std::string buffer;
+		std::string strings;
+	};
+
+	// 块的内容：从 quad_base 开始编号的 count 个四元式，Interner 中从各个 base 开始的名字、常量和复合操作数，
+	// 以及这些函数和变量表(variables 为空指针时不带变量表)
+	std::string encode_chunk(const std::pair<size_t, Quater>* code,
+	                         size_t count,
+	                         uint32_t quad_base,
+	                         const Interner& names,
+	                         uint32_t name_base,
+	                         uint32_t constant_base,
+	                         uint32_t compound_base,
+	                         const FunctionRange* functions,
+	                         size_t function_count,
+	                         const std::map<std::string, VaribleMeta>* variables,
+	                         uint32_t flags)
+	{
+		ChunkBuilder chunk;
+		chunk.header.quad_base = quad_base;
+		chunk.header.name_base = name_base;
+		chunk.header.constant_base = constant_base;
+		chunk.header.compound_base = compound_base;
+
+		std::vector<IRQuad> quads;
+		quads.reserve(count);
+		for (size_t i = 0; i < count; ++i) {
+			const Quater& quater = code[i].second;
+			quads.push_back(IRQuad{static_cast<uint8_t>(quater.op), {}, quater.arg1.raw(), quater.arg2.raw(), quater.result.raw()});
+		}
+		chunk.header.quads = chunk.add(quads);
+
+		std::vector<IRString> name_records;
+		for (uint32_t i = name_base; i < names.name_count(); ++i) {
+			name_records.push_back(chunk.add_string(names.name(i)));
+		}
+		chunk.header.names = chunk.add(name_records);
+
+		std::vector<IRConstant> constants;
+		for (uint32_t i = constant_base; i < names.constant_count(); ++i) {
+			const Constant& constant = names.constant(i);
+			constants.push_back(IRConstant{static_cast<uint8_t>(constant.kind), {}, chunk.add_string(constant.text), 0, constant.integer, constant.real});
+		}
+		chunk.header.constants = chunk.add(constants);
+
+		std::vector<IRCompound> compounds;
+		for (uint32_t i = compound_base; i < names.compound_count(); ++i) {
+			const Compound& compound = names.compound(i);
+			compounds.push_back(IRCompound{static_cast<uint8_t>(compound.shape), {}, compound.first.raw(), compound.second.raw()});
+		}
+		chunk.header.compounds = chunk.add(compounds);
+
+		std::vector<IRVariable> variable_records;
+		if (variables != nullptr) {
+			for (const auto& [name, meta] : *variables) {
+				variable_records.push_back(IRVariable{chunk.add_string(name), chunk.add_string(meta.type), meta.value.raw(), 0});
+			}
+		}
+		chunk.header.variables = chunk.add(variable_records);
+
+		std::vector<IRFunction> function_records;
+		for (size_t i = 0; i < function_count; ++i) {
+			const FunctionRange& function = functions[i];
+			function_records.push_back(IRFunction{chunk.add_string(function.name), static_cast<uint32_t>(function.begin), static_cast<uint32_t>(function.end)});
+		}
+		chunk.header.functions = chunk.add(function_records);
+
+		return chunk.finish(flags);
+	}
+
+	// 文件不带缓冲，整块内容由一次 write 交给操作系统
+	std::FILE* open_unbuffered(const std::string& path)
+	{
+		std::FILE* file = std::fopen(path.c_str(), "wb");
+		if (file != nullptr) std::setvbuf(file, nullptr, _IONBF, 0);
+		return file;
+	}
+
+	bool write_buffer(std::FILE* file, const std::string& buffer)
+	{
+		return std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+	}
+}  // namespace
+
+std::string encode_ir(const std::vector<std::pair<size_t, Quater>>& code,
+                      const std::map<std::string, VaribleMeta>& variables,
+                      const Interner& names,
+                      const std::vector<FunctionRange>& functions)
+{
+	return encode_chunk(code.data(), code.size(), 0, names, 0, 0, 0, functions.data(), functions.size(), &variables, ir_chunk_last);
+}
+
+bool write_ir(const std::string& path,
+              const std::vector<std::pair<size_t, Quater>>& code,
+              const std::map<std::string, VaribleMeta>& variables,
+              const Interner& names,
+              const std::vector<FunctionRange>& functions)
+{
+	std::string buffer = encode_ir(code, variables, names, functions);
+	std::FILE* file = open_unbuffered(path);
+	if (file == nullptr) return false;
+	bool written = write_buffer(file, buffer);
+	return std::fclose(file) == 0 && written;
+}
+
+IRStreamWriter::~IRStreamWriter()
+{
+	if (file != nullptr) std::fclose(file);
+}
+
+bool IRStreamWriter::open(const std::string& path)
+{
+	file = open_unbuffered(path);
+	ok = file != nullptr;
+	return ok;
+}
+
+bool IRStreamWriter::write_chunk(const std::pair<size_t, Quater>* quads, size_t count, const Interner& names, const FunctionRange* function)
+{
+	if (!ok || (function != nullptr && (function->begin != quad_count || function->end != quad_count + count))) return ok = false;
+	ok = write_buffer(file, encode_chunk(quads, count, quad_count, names, name_count, constant_count, compound_count, function, function != nullptr ? 1 : 0, nullptr, 0));
+	quad_count += static_cast<uint32_t>(count);
+	name_count = static_cast<uint32_t>(names.name_count());
+	constant_count = static_cast<uint32_t>(names.constant_count());
+	compound_count = static_cast<uint32_t>(names.compound_count());
+	return ok;
+}
+
+bool IRStreamWriter::finish(const std::map<std::string, VaribleMeta>& variables, const Interner& names)
+{
+	if (ok) {
+		ok = write_buffer(file, encode_chunk(nullptr, 0, quad_count, names, name_count, constant_count, compound_count, nullptr, 0, &variables, ir_chunk_last));
+	}
+	if (file != nullptr && std::fclose(file) != 0) ok = false;
+	file = nullptr;
+	return ok;
+}
+
+bool write_ir_stream(const std::string& path,
+                     const std::vector<std::pair<size_t, Quater>>& code,
+                     const std::map<std::string, VaribleMeta>& variables,
+                     const Interner& names,
+                     const std::vector<FunctionRange>& functions)
+{
+	IRStreamWriter writer;
+	if (!writer.open(path)) return false;
+
+	size_t position = 0;
+	for (const FunctionRange& function : functions) {
+		if (position < function.begin) writer.write_chunk(code.data() + position, function.begin - position, names, nullptr);
+		writer.write_chunk(code.data() + function.begin, function.end - function.begin, names, &function);
+		position = function.end;
+	}
+	if (position < code.size()) writer.write_chunk(code.data() + position, code.size() - position, names, nullptr);
+	return writer.finish(variables, names);
+}
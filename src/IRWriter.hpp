@@ -0,0 +1,57 @@
+#pragma once
+
+#include "IRFormat.hpp"
+#include "Interner.hpp"
+#include "SymbolTable.hpp"
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 把整个结果编码为只有一块的二进制中间代码(格式见 IRFormat.hpp)
+std::string encode_ir(const std::vector<std::pair<size_t, Quater>>& code,
+                      const std::map<std::string, VaribleMeta>& variables,
+                      const Interner& names,
+                      const std::vector<FunctionRange>& functions);
+
+// 编码后用一次 write 写出到 path
+bool write_ir(const std::string& path,
+              const std::vector<std::pair<size_t, Quater>>& code,
+              const std::map<std::string, VaribleMeta>& variables,
+              const Interner& names,
+              const std::vector<FunctionRange>& functions);
+
+// 按函数分块写出，写完一块就交给操作系统，不必等整个结果编码完
+// 每块只带上一块之后 Interner 中新增的名字、常量和复合操作数，所以调用之间 Interner 只能追加
+class IRStreamWriter {
+public:
+	IRStreamWriter() = default;
+	~IRStreamWriter();
+
+	IRStreamWriter(const IRStreamWriter&) = delete;
+	IRStreamWriter& operator=(const IRStreamWriter&) = delete;
+
+	bool open(const std::string& path);
+	// 写出接在已写部分之后的 count 个四元式，function 非空时它们是这个函数的代码
+	bool write_chunk(const std::pair<size_t, Quater>* quads, size_t count, const Interner& names, const FunctionRange* function);
+	// 已写出的四元式个数，也就是下一块第一个四元式的编号
+	size_t written_quads() const { return quad_count; }
+	// 写出剩下的名字和常量、变量表作为最后一块，然后关闭文件
+	bool finish(const std::map<std::string, VaribleMeta>& variables, const Interner& names);
+
+private:
+	std::FILE* file = nullptr;
+	bool ok = false;
+	uint32_t quad_count = 0;
+	uint32_t name_count = 0;
+	uint32_t constant_count = 0;
+	uint32_t compound_count = 0;
+};
+
+// 流式写出整个结果：函数和函数之间的代码依次各写一块，变量表在最后一块
+bool write_ir_stream(const std::string& path,
+                     const std::vector<std::pair<size_t, Quater>>& code,
+                     const std::map<std::string, VaribleMeta>& variables,
+                     const Interner& names,
+                     const std::vector<FunctionRange>& functions);
@@ -0,0 +1,140 @@
+#include "Interner.hpp"
+#include <cstdlib>
+
+Operand Interner::variable(const std::string& name)
+{
+	auto it = name_ids.find(name);
+	if (it != name_ids.end()) return Operand(Operand::Kind::VARIABLE, it->second);
+
+	uint32_t id = static_cast<uint32_t>(names.size());
+	names.push_back(name);
+	name_ids.emplace(name, id);
+	return Operand(Operand::Kind::VARIABLE, id);
+}
+
+Operand Interner::find_variable(const std::string& name) const
+{
+	auto it = name_ids.find(name);
+	return it != name_ids.end() ? Operand(Operand::Kind::VARIABLE, it->second) : Operand();
+}
+
+Operand Interner::constant(Operand::Kind kind, const std::string& text)
+{
+	std::string key = static_cast<char>('0' + static_cast<int>(kind)) + text;
+	auto it = constant_ids.find(key);
+	if (it != constant_ids.end()) return Operand(kind, it->second);
+
+	Constant value;
+	value.kind = kind;
+	value.text = text;
+	if (kind == Operand::Kind::INT) {
+		value.integer = std::strtoll(text.c_str(), nullptr, 10);
+	} else if (kind == Operand::Kind::FLOAT) {
+		value.real = std::strtod(text.c_str(), nullptr);
+	} else if (kind == Operand::Kind::CHAR && text.size() >= 3) {
+		value.integer = static_cast<unsigned char>(text[1]);  // 词法分析器保证字符常量为 'x' 的形式
+	}
+
+	uint32_t id = static_cast<uint32_t>(constants.size());
+	constants.push_back(std::move(value));
+	constant_ids.emplace(std::move(key), id);
+	return Operand(kind, id);
+}
+
+Operand Interner::compound(Compound::Shape shape, Operand first, Operand second)
+{
+	auto& ids = compound_ids[static_cast<size_t>(shape)];
+	uint64_t key = static_cast<uint64_t>(first.raw()) << 32 | second.raw();
+	auto it = ids.find(key);
+	if (it != ids.end()) return Operand(Operand::Kind::COMPOUND, it->second);
+
+	uint32_t id = static_cast<uint32_t>(compounds.size());
+	compounds.push_back(Compound{shape, first, second});
+	ids.emplace(key, id);
+	return Operand(Operand::Kind::COMPOUND, id);
+}
+
+bool Interner::contains(Operand operand) const
+{
+	if (operand.kind() == Operand::Kind::VARIABLE) return operand.index() < names.size();
+	if (operand.is_constant()) return operand.index() < constants.size() && constants[operand.index()].kind == operand.kind();
+	if (operand.kind() == Operand::Kind::COMPOUND) return operand.index() < compounds.size();
+	return operand.kind() <= Operand::Kind::LABEL;
+}
+
+Operand Interner::import(const Interner& other, Operand operand, size_t temp_offset)
+{
+	switch (operand.kind()) {
+	case Operand::Kind::VARIABLE:
+		return variable(other.name(operand.index()));
+	case Operand::Kind::TEMP:
+		return Operand::temp(operand.index() + temp_offset);
+	case Operand::Kind::COMPOUND: {
+		// other 可能就是本表，先复制一份再驻留
+		Compound part = other.compound(operand.index());
+		return compound(part.shape, import(other, part.first, temp_offset), import(other, part.second, temp_offset));
+	}
+	default:
+		if (operand.is_constant()) return constant(operand.kind(), other.constant(operand.index()).text);
+		return operand;
+	}
+}
+
+std::string Interner::to_string(Operand operand) const
+{
+	std::string text;
+	append_text(text, operand);
+	return text;
+}
+
+std::string Interner::to_string(const Quater& quater) const
+{
+	std::string text;
+	append_text(text, quater);
+	return text;
+}
+
+size_t Interner::text_length(Operand operand) const
+{
+	auto digits = [](uint32_t value) {
+		size_t length = 1;
+		for (; value >= 10; value /= 10) ++length;
+		return length;
+	};
+	switch (operand.kind()) {
+	case Operand::Kind::NONE:
+		return 0;
+	case Operand::Kind::VARIABLE:
+		return names[operand.index()].size();
+	case Operand::Kind::TEMP:
+		return 1 + digits(operand.index());
+	case Operand::Kind::LABEL:
+		return digits(operand.index());
+	case Operand::Kind::COMPOUND: {
+		const Compound& part = compounds[operand.index()];
+		return text_length(part.first) + text_length(part.second) + (part.shape == Compound::Shape::LIST ? 1 : 2);
+	}
+	default:
+		return constants[operand.index()].text.size();
+	}
+}
+
+uint8_t Interner::text_marks(Operand operand) const
+{
+	if (operand.kind() == Operand::Kind::COMPOUND) {
+		const Compound& part = compounds[operand.index()];
+		uint8_t marks = text_marks(part.first) | text_marks(part.second);
+		if (part.shape == Compound::Shape::CALL) marks |= MARK_RIGHT_PAREN;
+		if (part.shape == Compound::Shape::LIST) marks |= MARK_COMMA;
+		return marks;
+	}
+	if (!operand.is_constant()) return 0;  // 名字、临时变量和标号中不会有这些字符
+
+	uint8_t marks = 0;
+	for (char c : constants[operand.index()].text) {
+		if (c == ',') marks |= MARK_COMMA;
+		if (c == ')') marks |= MARK_RIGHT_PAREN;
+		if (c == '\n') marks |= MARK_NEWLINE;
+	}
+	return marks;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Quater.hpp"
+#include <charconv>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 四元式中的常量：保留源代码中的写法用于输出，同时保存解析好的值
+struct Constant
+{
+	Operand::Kind kind;
+	std::string text;
+	int64_t integer = 0;  // 整数和字符常量的值
+	double real = 0;      // 浮点常量的值
+};
+
+// 复合操作数：还不翻译的函数调用 first(second)、数组元素 first[second]，以及实参列表 first,second
+struct Compound
+{
+	enum class Shape : uint8_t {
+		CALL,
+		INDEX,
+		LIST,
+		COUNT
+	};
+
+	Shape shape;
+	Operand first;
+	Operand second;  // 没有实参的调用为空
+};
+
+// 变量名、常量和复合操作数的驻留表，四元式里只保存它们在表中的编号
+// 同一个名字或常量只保存一份，编号按第一次出现的顺序分配
+class Interner {
+public:
+	Operand variable(const std::string& name);
+	Operand constant(Operand::Kind kind, const std::string& text);
+	Operand compound(Compound::Shape shape, Operand first, Operand second);
+	// 已经驻留的变量名，没有时返回空操作数(不会驻留，可以和其他只读操作并发)
+	Operand find_variable(const std::string& name) const;
+
+	const std::string& name(uint32_t id) const { return names[id]; }
+	const Constant& constant(uint32_t id) const { return constants[id]; }
+	const Compound& compound(uint32_t id) const { return compounds[id]; }
+	size_t name_count() const { return names.size(); }
+	size_t constant_count() const { return constants.size(); }
+	size_t compound_count() const { return compounds.size(); }
+
+	// 操作数引用的名字、常量或复合操作数是否在本表中
+	bool contains(Operand operand) const;
+	// 把 other 中的操作数换成本表中的编号，临时变量(包括复合操作数中的)编号加上 temp_offset，标号不变
+	// other 可以就是本表，用来给临时变量重新编号
+	Operand import(const Interner& other, Operand operand, size_t temp_offset = 0);
+
+	// 对操作数中的每个临时变量(包括复合操作数中的)调用 function(编号)
+	template <typename Function>
+	void for_each_temp(Operand operand, const Function& function) const
+	{
+		if (operand.kind() == Operand::Kind::TEMP) function(operand.index());
+		if (operand.kind() != Operand::Kind::COMPOUND) return;
+		for_each_temp(compounds[operand.index()].first, function);
+		for_each_temp(compounds[operand.index()].second, function);
+	}
+	// 把操作数中的临时变量 t 换成 rename(t)，复合操作数换成新的组合
+	template <typename Function>
+	Operand rename_temps(Operand operand, const Function& rename)
+	{
+		if (operand.kind() == Operand::Kind::TEMP) return Operand::temp(rename(operand.index()));
+		if (operand.kind() != Operand::Kind::COMPOUND) return operand;
+		Compound part = compounds[operand.index()];
+		return compound(part.shape, rename_temps(part.first, rename), rename_temps(part.second, rename));
+	}
+
+	// 操作数和四元式的文本形式，例如 t3、'a'、(+, a, 1, t0)
+	std::string to_string(Operand operand) const;
+	std::string to_string(const Quater& quater) const;
+	// 与 to_string 相同，但追加到 out(有 append(const char*, size_t) 的字符串或缓冲区)的末尾，
+	// 输出大量四元式时不必为每一条分配字符串
+	template <typename Output>
+	void append_text(Output& out, Operand operand) const;
+	template <typename Output>
+	void append_text(Output& out, const Quater& quater) const;
+	// 操作数文本的长度，不生成文本
+	size_t text_length(Operand operand) const;
+	// 操作数的文本中出现的特殊字符，输出表格时按它们切分四元式的文本
+	enum TextMark : uint8_t {
+		MARK_COMMA = 1 << 0,
+		MARK_RIGHT_PAREN = 1 << 1,
+		MARK_NEWLINE = 1 << 2
+	};
+	uint8_t text_marks(Operand operand) const;
+
+private:
+	std::vector<std::string> names;
+	std::unordered_map<std::string, uint32_t> name_ids;
+	std::vector<Constant> constants;
+	std::unordered_map<std::string, uint32_t> constant_ids;  // 键为种类加上常量的写法
+	std::vector<Compound> compounds;
+	std::unordered_map<uint64_t, uint32_t> compound_ids[static_cast<size_t>(Compound::Shape::COUNT)];  // 键为两个操作数
+};
+
+template <typename Output>
+void Interner::append_text(Output& out, Operand operand) const
+{
+	char digits[16] = {'t'};
+	switch (operand.kind()) {
+	case Operand::Kind::NONE:
+		return;
+	case Operand::Kind::VARIABLE:
+		out.append(names[operand.index()].data(), names[operand.index()].size());
+		return;
+	case Operand::Kind::TEMP:
+		out.append(digits, std::to_chars(digits + 1, digits + sizeof(digits), operand.index()).ptr - digits);
+		return;
+	case Operand::Kind::LABEL:
+		out.append(digits, std::to_chars(digits, digits + sizeof(digits), operand.index()).ptr - digits);
+		return;
+	case Operand::Kind::COMPOUND: {
+		const Compound& part = compounds[operand.index()];
+		append_text(out, part.first);
+		out.append(part.shape == Compound::Shape::CALL ? "(" : part.shape == Compound::Shape::INDEX ? "[" : ",", 1);
+		append_text(out, part.second);
+		if (part.shape == Compound::Shape::CALL) out.append(")", 1);
+		if (part.shape == Compound::Shape::INDEX) out.append("]", 1);
+		return;
+	}
+	default:
+		out.append(constants[operand.index()].text.data(), constants[operand.index()].text.size());
+	}
+}
+
+template <typename Output>
+void Interner::append_text(Output& out, const Quater& quater) const
+{
+	const char* op = opcode_name(quater.op);
+	out.append("(", 1);
+	out.append(op, std::char_traits<char>::length(op));
+	out.append(", ", 2);
+	if (quater.arg1.empty()) out.append("_", 1);
+	append_text(out, quater.arg1);
+	out.append(", ", 2);
+	if (quater.arg2.empty()) out.append("_", 1);
+	append_text(out, quater.arg2);
+	out.append(", ", 2);
+	append_text(out, quater.result);
+	out.append(")", 1);
+}
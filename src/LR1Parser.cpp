@@ -1,597 +1,976 @@
-#include <iostream>
-#include "LR1Parser.hpp"
-
-LR1Parser::LR1Parser(const std::vector<Production>& productions, Symbol start, Symbol end)
-    : productions(productions), start_symbol(start), end_symbol(end)
-{
-	for (const auto& production : productions) {
-		productionMap[production.lhs].push_back(production);
-	}
-	calculate_firstSets();
-	construct_tables();
-}
-
-LR1Parser::LR1Parser(const std::string file_path)
-{
-	std::ifstream file(file_path);
-	if (!file.is_open()) {
-		std::cerr << "无法打开文件: " + file_path << '\n';
-	}
-
-	std::string first_line;
-	if (!std::getline(file, first_line)) {
-		std::cerr << "文件格式错误: 第首行必须定义起始符合终止符" << std::endl;
-	}
-	std::istringstream is(first_line);
-	std::string temp;
-	is >> temp;
-	start_symbol = Symbol(SymbolType::NonTerminal, temp);
-	is >> temp;
-	end_symbol = Symbol(SymbolType::Terminal, temp);
-
-	std::string terminalsLine;
-	if (!std::getline(file, terminalsLine)) {
-		std::cerr << "文件格式错误: 第二行必须定义终结符" << std::endl;
-	}
-	std::istringstream iss(terminalsLine);
-	std::string terminal;
-	while (iss >> terminal) {
-		terminals.insert(terminal);
-	}
-
-	std::string line;
-	while (std::getline(file, line)) {
-		parse_EBNF_line(line);
-	}
-
-	calculate_firstSets();
-	construct_tables();
-}
-
-void LR1Parser::parse_EBNF_line(const std::string& line)
-{
-	std::istringstream iss(line);
-	std::string lhs, rhsPart, token;
-
-	// 读取非终结符，自动忽略前导空格
-	iss >> lhs;
-	// 忽略 "::="
-	std::string ignoreStr;
-	std::getline(iss, ignoreStr, '=');
-
-	// 读取并解析产生式右侧
-	std::getline(iss, rhsPart);
-	std::istringstream rhsStream(rhsPart);
-
-	// 用 '|' 分割产生式右边的语句
-	while (std::getline(rhsStream, token, '|')) {
-		std::istringstream tokenStream(token);
-		std::vector<Symbol> rhsSymbols;
-
-		// 获取产生式右边的符号
-		std::string sym;
-		while (tokenStream >> sym) {
-			SymbolType type;
-			if (sym == "Epsilon") {
-				type = SymbolType::Epsilon;
-			} else {
-				type = terminals.find(sym) == terminals.end() ? SymbolType::NonTerminal : SymbolType::Terminal;
-			}
-			rhsSymbols.push_back(Symbol(type, sym));
-		}
-
-		// 创建产生式并添加到某个容器中
-		productionMap[Symbol(SymbolType::NonTerminal, lhs)].push_back(Production{Symbol(SymbolType::NonTerminal, lhs), rhsSymbols});
-		productions.push_back(Production(Symbol(SymbolType::NonTerminal, lhs), rhsSymbols));
-	}
-}
-
-
-void LR1Parser::calculate_firstSets()
-{
-	for (const auto& [lhs, rhs] : productions) {
-		firstSet[lhs] = {};
-		for (const auto& symbol : rhs) {
-			if (symbol.type == SymbolType::NonTerminal) {
-				firstSet[symbol] = {};
-			} else if (symbol.type == SymbolType::Terminal) {
-				firstSet[symbol] = {symbol};
-			} else if (symbol.type == SymbolType::Epsilon) {
-				firstSet[symbol] = {Symbol(SymbolType::Epsilon, "")};
-			}
-		}
-	}
-
-	bool changed;
-	do {
-		changed = false;
-		for (const auto& [nonTerminal, productions] : productionMap) {
-			for (const auto& prod : productions) {
-				size_t i;
-				for (i = 0; i < prod.rhs.size(); ++i) {
-					const Symbol& symbol = prod.rhs[i];
-					std::unordered_set<Symbol, SymbolHash, SymbolEqual> symbolFirstSet = firstSet[symbol];
-					size_t oldSize = firstSet[nonTerminal].size();
-					bool has_epsilon = true;
-
-					// If the symbol does not contain epsilon, break
-					if (symbolFirstSet.find(Symbol(SymbolType::Epsilon, "")) == symbolFirstSet.end()) {
-						has_epsilon = false;
-					}
-
-					// Remove epsilon if not the last symbol
-					if (i < prod.rhs.size() - 1) {
-						symbolFirstSet.erase(Symbol(SymbolType::Epsilon, ""));
-					}
-					firstSet[nonTerminal].insert(symbolFirstSet.begin(), symbolFirstSet.end());
-
-					// Check if FIRST set has changed
-					if (firstSet[nonTerminal].size() != oldSize) {
-						changed = true;
-					}
-
-					if (!has_epsilon) break;
-				}
-
-				// If all symbols in production can lead to epsilon, add epsilon to FIRST(nonTerminal)
-				if (i == prod.rhs.size()) {
-					firstSet[nonTerminal].insert(Symbol(SymbolType::Epsilon, ""));
-				}
-			}
-		}
-	} while (changed);  // Repeat until no changes are made
-}
-
-std::unordered_set<Symbol, SymbolHash, SymbolEqual> LR1Parser::get_first_string(std::vector<Symbol> content) const
-{
-	std::unordered_set<Symbol, SymbolHash, SymbolEqual> ret;
-	for (const auto& symbol : content) {
-		if (symbol.type == SymbolType::Epsilon) continue;
-		if (symbol.type == SymbolType::Terminal) {
-			ret.insert(symbol);
-			break;
-		}
-		std::unordered_set<Symbol, SymbolHash, SymbolEqual> symbolFirstSet = firstSet.at(symbol);
-		symbolFirstSet.erase(Symbol(SymbolType::Epsilon, ""));
-		ret.insert(symbolFirstSet.begin(), symbolFirstSet.end());
-		if (ret.size() > 0) break;
-	}
-	return ret;
-}
-
-
-LR1Item::State LR1Parser::get_lr1item_state(const LR1Item& item) const
-{
-	const auto& production = item.production;
-	const auto& dot_position = item.dot_position;
-	const auto& lookahead = item.lookahead;
-
-	// 检查是否是接受状态
-	if (production.lhs == start_symbol && dot_position == production.rhs.size() && lookahead == end_symbol) {
-		return LR1Item::State::ACCEPT;
-	}
-
-	// 检查是否是归约状态
-	if (dot_position == production.rhs.size()) {
-		return LR1Item::State::REDUCE;
-	}
-
-	// 检查是否是移进状态
-	if (dot_position < production.rhs.size() && production.rhs[dot_position].type == SymbolType::Terminal) {
-		return LR1Item::State::SHIFT;
-	}
-
-	// 检查是否是转换状态
-	if (dot_position < production.rhs.size() && production.rhs[dot_position].type == SymbolType::NonTerminal) {
-		return LR1Item::State::GOTO;
-	}
-
-	// 如果没有匹配的状态，可能是一个错误或未定义的状态
-	throw std::runtime_error("Undefined state for LR1 item.");
-}
-
-void LR1Parser::closure(std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual>& old_set) const
-{
-	bool changed = true;
-	std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual> vis_item;
-	while (changed) {
-		changed = false;
-		std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual> items_to_add;
-
-		for (const auto& item : old_set) {
-			// 只有GOTO状态(.后面是非终结符)才需要处理
-			if (get_lr1item_state(item) != LR1Item::State::GOTO) continue;
-			if (vis_item.find(item) != vis_item.end()) continue;
-			vis_item.insert(item);
-
-			Symbol next_symbol = item.next_symbol();
-			Symbol nnext_symbol = item.nnext_symbol();
-			// 找到文法中所有以next_symbol为lhs的产生式
-			std::vector<Production> next_prods = get_productions_start_by_symbol(next_symbol);
-			for (const auto& prod : next_prods) {
-				std::unordered_set<Symbol, SymbolHash, SymbolEqual> lookaheads = get_first_string({nnext_symbol, item.lookahead});
-				for (const auto& p_lh : lookaheads) {
-					LR1Item new_item(prod, 0, p_lh);
-					if (old_set.find(new_item) == old_set.end()) {
-						items_to_add.insert(new_item);
-						changed = true;
-					}
-				}
-			}
-		}
-
-		old_set.insert(items_to_add.begin(), items_to_add.end());
-	}
-}
-
-
-std::vector<Production> LR1Parser::get_productions_start_by_symbol(const Symbol& symbol) const
-{
-	auto it = productionMap.find(symbol);
-	if (it == productionMap.end()) return std::vector<Production>();
-	return it->second;
-}
-
-void LR1Parser::print_firstSet() const
-{
-	for (const auto& [symbol, firstSetSymbols] : firstSet) {
-		std::cout << "FIRST(" << symbol.literal << ") = { ";
-		for (const auto& sym : firstSetSymbols) {
-			std::cout << sym.literal << " ";
-		}
-		std::cout << "}" << std::endl;
-	}
-}
-
-void LR1Parser::print_tables() const
-{
-	// 打印ACTION表
-	std::cout << "ACTION Table:" << std::endl;
-	for (const auto& entry : actionTable) {
-		const auto& state_symbol_pair = entry.first;
-		const auto& action = entry.second;
-
-		std::cout << "State " << state_symbol_pair.first << ", Symbol " << state_symbol_pair.second.to_string()
-		          << ": " << action.to_string() << "" << std::endl;
-	}
-
-	// 打印GOTO表
-	std::cout << "\nGOTO Table:" << std::endl;
-	for (const auto& entry : gotoTable) {
-		const auto& state_symbol_pair = entry.first;
-		const auto& nextState = entry.second;
-
-		std::cout << "State " << state_symbol_pair.first << ", Symbol " << state_symbol_pair.second.to_string()
-		          << ": " << nextState << "" << std::endl;
-	}
-}
-
-void LR1Parser::construct_tables()
-{
-	Production begin_production = get_productions_start_by_symbol(start_symbol).at(0);
-	lr1ItemSets.push_back(std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual>({LR1Item(begin_production, 0, end_symbol)}));
-	closure(lr1ItemSets[0]);
-
-	for (size_t index = 0; index < lr1ItemSets.size(); ++index) {
-		std::vector<LR1Item> shift_items, reduce_items, accept_items, goto_items;
-		std::vector<Symbol> VT_shift, VN_goto;
-		// std::cout << index << '\n';
-		for (auto& item : lr1ItemSets[index]) {
-			// std::cout << item.to_string() << ' ' << (int)get_lr1item_state(item) << '\n';
-			switch (get_lr1item_state(item)) {
-				case LR1Item::State::ACCEPT:
-					accept_items.push_back(item);
-					break;
-				case LR1Item::State::GOTO:
-					goto_items.push_back(item);
-					VN_goto.push_back(item.next_symbol());
-					break;
-				case LR1Item::State::REDUCE:
-					reduce_items.push_back(item);
-					break;
-				case LR1Item::State::SHIFT:
-					shift_items.push_back(item);
-					VT_shift.push_back(item.next_symbol());
-					break;
-				default:
-					std::cerr << "construct_tables() 中LR1Item类型错误" << std::endl;
-			}
-		}
-
-		for (auto& vt : VT_shift) {
-			std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual> new_set;
-			for (auto& item : lr1ItemSets[index]) {
-				if (get_lr1item_state(item) == LR1Item::State::SHIFT && item.next_symbol() == vt) {
-					new_set.insert(LR1Item(item.production, item.dot_position + 1, item.lookahead));
-				}
-			}
-			closure(new_set);
-			size_t id = find(lr1ItemSets.begin(), lr1ItemSets.end(), new_set) - lr1ItemSets.begin();
-			if (id == lr1ItemSets.size()) {
-				lr1ItemSets.push_back(new_set);
-			}
-			actionTable[{index, vt}] = Action(Action::Type::SHIFT, id, Production());
-		}
-
-		for (auto& vn : VN_goto) {
-			std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual> new_set;
-			for (auto& item : lr1ItemSets[index]) {
-				if (get_lr1item_state(item) == LR1Item::State::GOTO && item.next_symbol() == vn) {
-					new_set.insert(LR1Item(item.production, item.dot_position + 1, item.lookahead));
-				}
-			}
-			closure(new_set);
-			size_t id = find(lr1ItemSets.begin(), lr1ItemSets.end(), new_set) - lr1ItemSets.begin();
-			if (id == lr1ItemSets.size()) {
-				lr1ItemSets.push_back(new_set);
-			}
-			gotoTable[{index, vn}] = id;
-		}
-
-		for (auto& item : accept_items) {
-			actionTable[{index, item.lookahead}] = Action(Action::Type::ACCEPT, -1, Production());
-		}
-
-		for (auto& item : reduce_items) {
-			actionTable[{index, item.lookahead}] = Action(Action::Type::REDUCE, -1, item.production);
-		}
-	}
-}
-
-bool LR1Parser::parse(const std::vector<Symbol>& sentence, SemanticTreeNode*& root) const
-{
-	std::stack<int> stateStack;                                          // 状态栈
-	std::stack<Symbol> symbolStack;                                      // 符号栈
-	std::vector<Symbol> inputStack(sentence.rbegin(), sentence.rend());  // 输入栈
-
-	std::vector<SemanticTreeNode*> nodeStack;  // 解析树结点栈
-
-	// 初始状态
-	stateStack.push(0);
-
-
-	while (!inputStack.empty()) {
-		int currentState = stateStack.top();
-		Symbol currentSymbol = inputStack.back();
-
-		// 打印当前栈的状态
-		// print_stacks(stateStack, symbolStack, inputStack);
-
-		auto actionIt = actionTable.find({currentState, currentSymbol});
-		if (actionIt != actionTable.end()) {
-			const Action& action = actionIt->second;
-
-			switch (action.type) {
-				case Action::Type::SHIFT: {
-					stateStack.push(action.number);
-					symbolStack.push(currentSymbol);
-					inputStack.pop_back();
-
-					// 创建一个新的叶子节点并压入节点栈
-					SemanticTreeNode* newNode = new SemanticTreeNode(currentSymbol);
-					nodeStack.push_back(newNode);
-					break;
-				}
-				case Action::Type::REDUCE: {
-					// 创建一个新的非叶子节点
-					SemanticTreeNode* newNode = new SemanticTreeNode(action.production.lhs);
-
-					// 根据产生式右侧的长度，从栈中弹出相应数量的符号和状态
-					for (size_t i = 0; i < action.production.rhs.size(); ++i) {
-						symbolStack.pop();
-						stateStack.pop();
-
-						newNode->children.insert(newNode->children.begin(), nodeStack.back());
-						nodeStack.pop_back();
-					}
-					// 将新节点压入节点栈
-					nodeStack.push_back(newNode);
-
-					// 将产生式左侧的非终结符压入符号栈
-					symbolStack.push(action.production.lhs);
-
-					// 更新状态栈
-					int nextState = gotoTable.at({stateStack.top(), action.production.lhs});
-					stateStack.push(nextState);
-					break;
-				}
-				case Action::Type::ACCEPT:
-					std::cout << "Accept" << std::endl;
-					root = nodeStack.back();  // 设置解析树的根
-					return true;
-				default:
-					std::cerr << "Parse error" << std::endl;
-					return false;
-			}
-		} else {
-			std::cerr << "Parse error: no action" << std::endl;
-			return false;
-		}
-	}
-
-	std::cerr << "Parse error: input not consumed" << std::endl;
-	return false;
-}
-
-void LR1Parser::print_stacks(const std::stack<int>& stateStack,
-                             const std::stack<Symbol>& symbolStack,
-                             const std::vector<Symbol>& inputStack) const
-{
-	// 使用向量来反转栈的内容
-	std::vector<int> reversedStateStack;
-	std::vector<Symbol> reversedSymbolStack;
-
-	// 从栈中复制到向量
-	auto tempStateStack = stateStack;
-	while (!tempStateStack.empty()) {
-		reversedStateStack.push_back(tempStateStack.top());
-		tempStateStack.pop();
-	}
-
-	auto tempSymbolStack = symbolStack;
-	while (!tempSymbolStack.empty()) {
-		reversedSymbolStack.push_back(tempSymbolStack.top());
-		tempSymbolStack.pop();
-	}
-
-	// 逆序打印向量，从而按栈底到栈顶的顺序输出
-	std::cout << "State Stack: ";
-	for (auto it = reversedStateStack.rbegin(); it != reversedStateStack.rend(); ++it) {
-		std::cout << *it << " ";
-	}
-	std::cout << "\n";
-
-	std::cout << "Symbol Stack: ";
-	for (auto it = reversedSymbolStack.rbegin(); it != reversedSymbolStack.rend(); ++it) {
-		std::cout << it->to_string() << " ";
-	}
-	std::cout << "\n";
-
-	std::cout << "Input Stack: ";
-	for (auto it = inputStack.rbegin(); it != inputStack.rend(); ++it) {
-		std::cout << it->to_string() << " ";
-	}
-	std::cout << "\n"
-	          << std::endl;
-}
-
-void LR1Parser::save_tables(const std::string& file_path)
-{
-	std::ofstream fout(file_path);
-	if (!fout.is_open()) {
-		std::cerr << "文件打开失败！" << std::endl;
-		exit(-1);
-	}
-
-	// 序列化 actionTable
-	for (auto& item : actionTable) {
-		int t1 = item.first.first;
-		Symbol t2 = item.first.second;
-		Action t3 = item.second;
-		fout << t1 << " " << t2 << " " << t3 << "" << std::endl;
-	}
-
-	// 可能需要一个分隔符来区分两个表
-	fout << "---" << std::endl;
-
-	// 序列化 gotoTable
-	for (auto& item : gotoTable) {
-		int t1 = item.first.first;
-		Symbol t2 = item.first.second;
-		int t3 = item.second;
-		fout << t1 << " " << t2 << " " << t3 << "" << std::endl;
-	}
-
-	fout.close();
-}
-
-void LR1Parser::load_tables(const std::string& file_path)
-{
-	std::ifstream fin(file_path);
-	if (!fin.is_open()) {
-		std::cerr << "文件打开失败！" << std::endl;
-		exit(-1);
-	}
-
-	std::string line;
-	bool readingActionTable = true;  // 初始假设从actionTable开始读取
-
-	while (std::getline(fin, line)) {
-		if (line == "---") {
-			// 遇到分隔符，切换到读取 gotoTable
-			readingActionTable = false;
-			continue;
-		}
-		std::istringstream iss(line);
-		int state;
-		Symbol symbol;
-		iss >> state >> symbol;
-
-		if (readingActionTable) {
-			Action action;
-			iss >> action;
-			actionTable[{state, symbol}] = action;
-		} else {
-			int gotoState;
-			iss >> gotoState;
-			gotoTable[{state, symbol}] = gotoState;
-		}
-	}
-
-	fin.close();
-}
-
-size_t SemanticTreeNode::add_quater(const Quater& quater)
-{
-	size_t this_id = next_quater_id++;
-	quater_list.push_back({this_id, quater});
-	return this_id;
-}
-size_t SemanticTreeNode::add_quater(const size_t& id, const Quater& quater)
-{
-	quater_list.push_back({id, quater});
-	return id;
-}
-size_t SemanticTreeNode::add_quater(const std::string& op, const std::string& arg1, const std::string& arg2, const std::string& result)
-{
-	Quater quater = Quater(op, arg1, arg2, result);
-	size_t this_id = next_quater_id++;
-	quater_list.push_back({this_id, quater});
-	return this_id;
-}
-size_t SemanticTreeNode::add_quater(const std::string& op, const std::string& arg1, const std::string& arg2, const size_t& result)
-{
-	Quater quater = Quater(op, arg1, arg2, std::to_string(result));
-	size_t this_id = next_quater_id++;
-	quater_list.push_back({this_id, quater});
-	return this_id;
-}
-void SemanticTreeNode::append_quaters(const std::vector<std::pair<size_t, Quater>>& quaters)
-{
-	size_t base_id = next_quater_id;
-	for (const auto& [id, quater] : quaters) {
-		if (quater.is_jump()) {
-			// 跳转语句不仅id要+base_id, 而且result也要加
-			Quater q(quater);
-			q.result = std::to_string(std::stoi(q.result) + base_id);
-			this->add_quater(id + base_id, q);
-			continue;
-		}
-
-		this->add_quater(id + base_id, quater);
-	}
-	next_quater_id += quaters.size();
-}
-
-
-// int main()
-// {
-// 	// 定义非终结符
-// 	Symbol S(SymbolType::NonTerminal, "S");
-// 	Symbol B(SymbolType::NonTerminal, "B");
-// 	Symbol S_prime(SymbolType::NonTerminal, "S'");
-
-// 	// 定义终结符
-// 	Symbol a(SymbolType::Terminal, "a");
-// 	Symbol b(SymbolType::Terminal, "b");
-
-// 	// 定义产生式
-// 	Production p1(S_prime, {S});
-// 	Production p2(S, {B, B});
-// 	Production p3(B, {a, B});
-// 	Production p4(B, {b});
-
-// 	// std::vector<Production> productions = {p1, p2, p3, p4};
-
-// 	// // 创建LR1解析器实例
-// 	// LR1Parser parser(productions, S_prime, Symbol(SymbolType::Terminal, "$"));
-// 	LR1Parser parser("grammer.txt");
-
-// 	parser.print_firstSet();
-// 	parser.print_tables();
-
-// 	// std::vector<Symbol> sentence = {a, b, a, b, Symbol(SymbolType::Terminal, "$")};
-// 	// parser.parse(sentence);
-
-// 	return 0;
+#include <iostream>
+#include "LR1Parser.hpp"
+#include "CompactTree.hpp"
+#include "ParseStats.hpp"
+#include "ThreadPool.hpp"
+
+LR1Parser::LR1Parser(const std::vector<Production>& productions, Symbol start, Symbol end)
+    : productions(productions), start_symbol(start), end_symbol(end)
+{
+	for (const auto& production : productions) {
+		productionMap[production.lhs].push_back(production);
+	}
+	calculate_firstSets();
+	construct_tables();
+}
+
+LR1Parser::LR1Parser(const std::string file_path)
+{
+	std::ifstream file(file_path);
+	if (!file.is_open()) {
+		std::cerr << "无法打开文件: " + file_path << '\n';
+	}
+
+	std::string first_line;
+	if (!std::getline(file, first_line)) {
+		std::cerr << "文件格式错误: 第首行必须定义起始符合终止符" << std::endl;
+	}
+	std::istringstream is(first_line);
+	std::string temp;
+	is >> temp;
+	start_symbol = Symbol(SymbolType::NonTerminal, temp);
+	is >> temp;
+	end_symbol = Symbol(SymbolType::Terminal, temp);
+
+	std::string terminalsLine;
+	if (!std::getline(file, terminalsLine)) {
+		std::cerr << "文件格式错误: 第二行必须定义终结符" << std::endl;
+	}
+	std::istringstream iss(terminalsLine);
+	std::string terminal;
+	while (iss >> terminal) {
+		terminals.insert(terminal);
+	}
+
+	std::string line;
+	while (std::getline(file, line)) {
+		parse_EBNF_line(line);
+	}
+
+	calculate_firstSets();
+	construct_tables();
+}
+
+void LR1Parser::parse_EBNF_line(const std::string& line)
+{
+	std::istringstream iss(line);
+	std::string lhs, rhsPart, token;
+
+	// 读取非终结符，自动忽略前导空格
+	iss >> lhs;
+	// 忽略 "::="
+	std::string ignoreStr;
+	std::getline(iss, ignoreStr, '=');
+
+	// 读取并解析产生式右侧
+	std::getline(iss, rhsPart);
+	std::istringstream rhsStream(rhsPart);
+
+	// 用 '|' 分割产生式右边的语句
+	while (std::getline(rhsStream, token, '|')) {
+		std::istringstream tokenStream(token);
+		std::vector<Symbol> rhsSymbols;
+
+		// 获取产生式右边的符号
+		std::string sym;
+		bool elide = false;
+		while (tokenStream >> sym) {
+			if (sym == "@elide") {
+				elide = true;
+				continue;
+			}
+			SymbolType type;
+			if (sym == "Epsilon") {
+				type = SymbolType::Epsilon;
+			} else {
+				type = terminals.find(sym) == terminals.end() ? SymbolType::NonTerminal : SymbolType::Terminal;
+			}
+			rhsSymbols.push_back(Symbol(type, sym));
+		}
+
+		// 创建产生式并添加到某个容器中，@elide 只对单产生式有效
+		Production production(Symbol(SymbolType::NonTerminal, lhs), rhsSymbols);
+		production.elide = elide && rhsSymbols.size() == 1;
+		productionMap[production.lhs].push_back(production);
+		productions.push_back(production);
+	}
+}
+
+
+void LR1Parser::calculate_firstSets()
+{
+	for (const auto& production : productions) {
+		firstSet[production.lhs] = {};
+		for (const auto& symbol : production.rhs) {
+			if (symbol.type == SymbolType::NonTerminal) {
+				firstSet[symbol] = {};
+			} else if (symbol.type == SymbolType::Terminal) {
+				firstSet[symbol] = {symbol};
+			} else if (symbol.type == SymbolType::Epsilon) {
+				firstSet[symbol] = {Symbol(SymbolType::Epsilon, "")};
+			}
+		}
+	}
+
+	bool changed;
+	do {
+		changed = false;
+		for (const auto& [nonTerminal, productions] : productionMap) {
+			for (const auto& prod : productions) {
+				size_t i;
+				for (i = 0; i < prod.rhs.size(); ++i) {
+					const Symbol& symbol = prod.rhs[i];
+					std::unordered_set<Symbol, SymbolHash, SymbolEqual> symbolFirstSet = firstSet[symbol];
+					size_t oldSize = firstSet[nonTerminal].size();
+					bool has_epsilon = true;
+
+					// If the symbol does not contain epsilon, break
+					if (symbolFirstSet.find(Symbol(SymbolType::Epsilon, "")) == symbolFirstSet.end()) {
+						has_epsilon = false;
+					}
+
+					// Remove epsilon if not the last symbol
+					if (i < prod.rhs.size() - 1) {
+						symbolFirstSet.erase(Symbol(SymbolType::Epsilon, ""));
+					}
+					firstSet[nonTerminal].insert(symbolFirstSet.begin(), symbolFirstSet.end());
+
+					// Check if FIRST set has changed
+					if (firstSet[nonTerminal].size() != oldSize) {
+						changed = true;
+					}
+
+					if (!has_epsilon) break;
+				}
+
+				// If all symbols in production can lead to epsilon, add epsilon to FIRST(nonTerminal)
+				if (i == prod.rhs.size()) {
+					firstSet[nonTerminal].insert(Symbol(SymbolType::Epsilon, ""));
+				}
+			}
+		}
+	} while (changed);  // Repeat until no changes are made
+}
+
+std::unordered_set<Symbol, SymbolHash, SymbolEqual> LR1Parser::get_first_string(std::vector<Symbol> content) const
+{
+	std::unordered_set<Symbol, SymbolHash, SymbolEqual> ret;
+	for (const auto& symbol : content) {
+		if (symbol.type == SymbolType::Epsilon) continue;
+		if (symbol.type == SymbolType::Terminal) {
+			ret.insert(symbol);
+			break;
+		}
+		std::unordered_set<Symbol, SymbolHash, SymbolEqual> symbolFirstSet = firstSet.at(symbol);
+		symbolFirstSet.erase(Symbol(SymbolType::Epsilon, ""));
+		ret.insert(symbolFirstSet.begin(), symbolFirstSet.end());
+		if (ret.size() > 0) break;
+	}
+	return ret;
+}
+
+
+LR1Item::State LR1Parser::get_lr1item_state(const LR1Item& item) const
+{
+	const auto& production = item.production;
+	const auto& dot_position = item.dot_position;
+	const auto& lookahead = item.lookahead;
+
+	// 检查是否是接受状态
+	if (production.lhs == start_symbol && dot_position == production.rhs.size() && lookahead == end_symbol) {
+		return LR1Item::State::ACCEPT;
+	}
+
+	// 检查是否是归约状态
+	if (dot_position == production.rhs.size()) {
+		return LR1Item::State::REDUCE;
+	}
+
+	// 检查是否是移进状态
+	if (dot_position < production.rhs.size() && production.rhs[dot_position].type == SymbolType::Terminal) {
+		return LR1Item::State::SHIFT;
+	}
+
+	// 检查是否是转换状态
+	if (dot_position < production.rhs.size() && production.rhs[dot_position].type == SymbolType::NonTerminal) {
+		return LR1Item::State::GOTO;
+	}
+
+	// 如果没有匹配的状态，可能是一个错误或未定义的状态
+	throw std::runtime_error("Undefined state for LR1 item.");
+}
+
+void LR1Parser::closure(std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual>& old_set) const
+{
+	bool changed = true;
+	std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual> vis_item;
+	while (changed) {
+		changed = false;
+		std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual> items_to_add;
+
+		for (const auto& item : old_set) {
+			// 只有GOTO状态(.后面是非终结符)才需要处理
+			if (get_lr1item_state(item) != LR1Item::State::GOTO) continue;
+			if (vis_item.find(item) != vis_item.end()) continue;
+			vis_item.insert(item);
+
+			Symbol next_symbol = item.next_symbol();
+			Symbol nnext_symbol = item.nnext_symbol();
+			// 找到文法中所有以next_symbol为lhs的产生式
+			std::vector<Production> next_prods = get_productions_start_by_symbol(next_symbol);
+			for (const auto& prod : next_prods) {
+				std::unordered_set<Symbol, SymbolHash, SymbolEqual> lookaheads = get_first_string({nnext_symbol, item.lookahead});
+				for (const auto& p_lh : lookaheads) {
+					LR1Item new_item(prod, 0, p_lh);
+					if (old_set.find(new_item) == old_set.end()) {
+						items_to_add.insert(new_item);
+						changed = true;
+					}
+				}
+			}
+		}
+
+		old_set.insert(items_to_add.begin(), items_to_add.end());
+	}
+}
+
+
+size_t LR1Parser::production_index(const Production& production) const
+{
+	return std::find(productions.begin(), productions.end(), production) - productions.begin();
+}
+
+std::vector<Production> LR1Parser::get_productions_start_by_symbol(const Symbol& symbol) const
+{
+	auto it = productionMap.find(symbol);
+	if (it == productionMap.end()) return std::vector<Production>();
+	return it->second;
+}
+
+void LR1Parser::print_firstSet() const
+{
+	for (const auto& [symbol, firstSetSymbols] : firstSet) {
+		std::cout << "FIRST(" << symbol.literal << ") = { ";
+		for (const auto& sym : firstSetSymbols) {
+			std::cout << sym.literal << " ";
+		}
+		std::cout << "}" << std::endl;
+	}
+}
+
+void LR1Parser::print_tables() const
+{
+	// 打印ACTION表
+	std::cout << "ACTION Table:" << std::endl;
+	for (const auto& entry : actionTable) {
+		const auto& state_symbol_pair = entry.first;
+		const auto& action = entry.second;
+
+		std::cout << "State " << state_symbol_pair.first << ", Symbol " << state_symbol_pair.second.to_string()
+		          << ": " << action.to_string() << "" << std::endl;
+	}
+
+	// 打印GOTO表
+	std::cout << "\nGOTO Table:" << std::endl;
+	for (const auto& entry : gotoTable) {
+		const auto& state_symbol_pair = entry.first;
+		const auto& nextState = entry.second;
+
+		std::cout << "State " << state_symbol_pair.first << ", Symbol " << state_symbol_pair.second.to_string()
+		          << ": " << nextState << "" << std::endl;
+	}
+}
+
+void LR1Parser::construct_tables()
+{
+	Production begin_production = get_productions_start_by_symbol(start_symbol).at(0);
+	lr1ItemSets.push_back(std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual>({LR1Item(begin_production, 0, end_symbol)}));
+	closure(lr1ItemSets[0]);
+
+	for (size_t index = 0; index < lr1ItemSets.size(); ++index) {
+		std::vector<LR1Item> shift_items, reduce_items, accept_items, goto_items;
+		std::vector<Symbol> VT_shift, VN_goto;
+		// std::cout << index << '\n';
+		for (auto& item : lr1ItemSets[index]) {
+			// std::cout << item.to_string() << ' ' << (int)get_lr1item_state(item) << '\n';
+			switch (get_lr1item_state(item)) {
+				case LR1Item::State::ACCEPT:
+					accept_items.push_back(item);
+					break;
+				case LR1Item::State::GOTO:
+					goto_items.push_back(item);
+					VN_goto.push_back(item.next_symbol());
+					break;
+				case LR1Item::State::REDUCE:
+					reduce_items.push_back(item);
+					break;
+				case LR1Item::State::SHIFT:
+					shift_items.push_back(item);
+					VT_shift.push_back(item.next_symbol());
+					break;
+				default:
+					std::cerr << "construct_tables() 中LR1Item类型错误" << std::endl;
+			}
+		}
+
+		for (auto& vt : VT_shift) {
+			std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual> new_set;
+			for (auto& item : lr1ItemSets[index]) {
+				if (get_lr1item_state(item) == LR1Item::State::SHIFT && item.next_symbol() == vt) {
+					new_set.insert(LR1Item(item.production, item.dot_position + 1, item.lookahead));
+				}
+			}
+			closure(new_set);
+			size_t id = find(lr1ItemSets.begin(), lr1ItemSets.end(), new_set) - lr1ItemSets.begin();
+			if (id == lr1ItemSets.size()) {
+				lr1ItemSets.push_back(new_set);
+			}
+			actionTable[{index, vt}] = Action(Action::Type::SHIFT, id, Production());
+		}
+
+		for (auto& vn : VN_goto) {
+			std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual> new_set;
+			for (auto& item : lr1ItemSets[index]) {
+				if (get_lr1item_state(item) == LR1Item::State::GOTO && item.next_symbol() == vn) {
+					new_set.insert(LR1Item(item.production, item.dot_position + 1, item.lookahead));
+				}
+			}
+			closure(new_set);
+			size_t id = find(lr1ItemSets.begin(), lr1ItemSets.end(), new_set) - lr1ItemSets.begin();
+			if (id == lr1ItemSets.size()) {
+				lr1ItemSets.push_back(new_set);
+			}
+			gotoTable[{index, vn}] = id;
+		}
+
+		// 接受和归约动作的 number 记录产生式编号
+		for (auto& item : accept_items) {
+			actionTable[{index, item.lookahead}] = Action(Action::Type::ACCEPT, production_index(item.production), item.production);
+		}
+
+		for (auto& item : reduce_items) {
+			actionTable[{index, item.lookahead}] = Action(Action::Type::REDUCE, production_index(item.production), item.production);
+		}
+	}
+}
+
+namespace {
+	thread_local std::ostream* error_output = nullptr;
+
+	std::ostream& error_stream() { return error_output != nullptr ? *error_output : std::cerr; }
+}  // namespace
+
+void LR1Parser::set_error_output(std::ostream* out)
+{
+	error_output = out;
+}
+
+namespace {
+	// 指针形式的语法树：结点和子结点数组都分配在 Arena 中
+	struct PointerTreeBuilder
+	{
+		using Node = SemanticTreeNode*;
+		Arena& arena;
+		const SemanticAction* on_reduce = nullptr;  // 每个内部结点建好后调用
+		uint32_t first_position = 0;                // 分析一段句子时，段首 token 在整个句子中的下标
+
+		Node leaf(const Symbol& symbol, int state, uint32_t position)
+		{
+			SemanticTreeNode* node = arena.create<SemanticTreeNode>(symbol);
+			node->token_begin = first_position + position;
+			node->token_end = first_position + position + 1;
+			node->start_state = state;
+			return node;
+		}
+
+		Node reduce(size_t production_id, const Production& production, const Node* children, size_t count, int state, uint32_t position)
+		{
+			// 子结点数组长度即产生式右侧长度
+			SemanticTreeNode* node = arena.create<SemanticTreeNode>(production.lhs);
+			node->children.data = arena.allocate_array<SemanticTreeNode*>(count);
+			node->children.count = count;
+			std::copy(children, children + count, node->children.data);
+
+			node->production_id = production_id;
+			node->start_state = state;
+			node->token_begin = count > 0 ? children[0]->token_begin : first_position + position;
+			node->token_end = count > 0 ? children[count - 1]->token_end : first_position + position;
+
+			if (on_reduce != nullptr) (*on_reduce)(node);
+			return node;
+		}
+	};
+
+	// 紧凑(结构数组)形式的语法树：结点按创建顺序即后序追加
+	struct CompactTreeBuilder
+	{
+		using Node = uint32_t;
+		CompactTree& tree;
+
+		Node leaf(const Symbol& symbol, int, uint32_t) { return tree.add_leaf(symbol); }
+
+		Node reduce(size_t production_id, const Production& production, const Node* children, size_t count, int, uint32_t)
+		{
+			return tree.add_node(production.lhs, static_cast<uint32_t>(production_id), children, count);
+		}
+	};
+
+	// 语法制导翻译：归约时立即执行该产生式的语义动作，结点栈同时充当属性栈
+	// 不保留语法树时，子结点的属性合并进父结点后即回收复用
+	struct TranslatingTreeBuilder
+	{
+		using Node = SemanticTreeNode*;
+		Arena& arena;
+		const std::vector<SemanticAction>& actions;
+		const SemanticAction& on_shift;
+		bool keep_tree;
+		std::vector<SemanticTreeNode*> free_nodes;
+
+		Node acquire(const Symbol& symbol)
+		{
+			if (free_nodes.empty()) return arena.create<SemanticTreeNode>(symbol);
+			SemanticTreeNode* node = free_nodes.back();
+			free_nodes.pop_back();
+			*node = SemanticTreeNode(symbol);
+			return node;
+		}
+
+		Node leaf(const Symbol& symbol, int, uint32_t position)
+		{
+			SemanticTreeNode* node = acquire(symbol);
+			node->token_begin = position;
+			node->token_end = position + 1;
+			if (on_shift) on_shift(node);
+			return node;
+		}
+
+		Node reduce(size_t production_id, const Production& production, const Node* children, size_t count, int, uint32_t position)
+		{
+			SemanticTreeNode* node = acquire(production.lhs);
+			node->children.data = const_cast<SemanticTreeNode**>(children);
+			node->children.count = count;
+			node->production_id = production_id;
+			node->token_begin = count > 0 ? children[0]->token_begin : position;
+			node->token_end = count > 0 ? children[count - 1]->token_end : position;
+
+			if (production_id < actions.size() && actions[production_id]) {
+				actions[production_id](node);
+			}
+
+			if (keep_tree) {
+				node->children.data = arena.allocate_array<SemanticTreeNode*>(count);
+				std::copy(children, children + count, node->children.data);
+			} else {
+				free_nodes.insert(free_nodes.end(), children, children + count);
+				node->children = ChildList();
+			}
+			return node;
+		}
+	};
+
+	// 普通分析不复用子树
+	struct NoSubtreeReuse
+	{
+		template <typename Node>
+		bool try_reuse(int, uint32_t&, Node&, Symbol&) { return false; }
+	};
+
+	// 按 token 位置从左到右遍历旧语法树，找出从当前位置开始、可以整体复用的子树
+	// 每个旧结点至多入栈出栈一次，被复用的子树不再展开，所以代价只和编辑附近的结点数有关
+	struct SubtreeReuseCursor
+	{
+		const std::vector<Production>& productions;
+		TokenEdit edit;
+		size_t& next_index;                      // 终结符来源下一次读取的下标
+		std::vector<SemanticTreeNode*> pending;  // 旧树中尚未越过的子树，栈顶位置最靠前
+
+		// 子树覆盖的 token 以及它后面的向前看 token 都不在编辑范围内
+		bool outside_edit(const SemanticTreeNode* node) const
+		{
+			return node->token_end < edit.begin || node->token_begin >= edit.old_end;
+		}
+
+		bool try_reuse(int state, uint32_t& position, SemanticTreeNode*& node, Symbol& lhs)
+		{
+			// 编辑范围内的新 token 在旧树中没有对应
+			if (position >= edit.begin && position < edit.new_end) return false;
+			size_t old_position = position < edit.begin ? position : position - edit.new_end + edit.old_end;
+
+			while (!pending.empty()) {
+				SemanticTreeNode* top = pending.back();
+				if (top->token_end <= old_position) {
+					// 已经越过
+					pending.pop_back();
+					continue;
+				}
+				if (top->token_begin > old_position) return false;
+
+				bool reusable = top->token_begin == old_position && !top->leaf() &&
+				                top->production_id < productions.size() &&
+				                top->start_state == state && outside_edit(top);
+				pending.pop_back();
+				if (!reusable) {
+					// 拆成子结点继续找，子结点从右往左压栈
+					for (size_t i = top->children.size(); i > 0; --i) {
+						pending.push_back(top->children[i - 1]);
+					}
+					continue;
+				}
+
+				node = top;
+				lhs = productions[top->production_id].lhs;
+				position = top->token_end < edit.begin ? top->token_end : top->token_end - edit.old_end + edit.new_end;
+				next_index = position;
+				return true;
+			}
+			return false;
+		}
+	};
+
+	// 并行分析时按顺序提供各段分析好的子树
+	struct FragmentCursor
+	{
+		const std::vector<size_t>& boundaries;
+		const std::vector<SemanticTreeNode*>& fragments;  // 分析失败的段为空指针
+		const Symbol& unit;
+		size_t& next_index;
+		size_t next = 0;  // 下一个可能复用的段
+
+		bool try_reuse(int state, uint32_t& position, SemanticTreeNode*& node, Symbol& lhs)
+		{
+			while (next < fragments.size() && boundaries[next] < position) ++next;
+			if (next == fragments.size() || boundaries[next] != position) return false;
+
+			SemanticTreeNode* fragment = fragments[next];
+			if (fragment == nullptr || fragment->start_state != state) return false;
+
+			node = fragment;
+			lhs = unit;
+			position = static_cast<uint32_t>(boundaries[next + 1]);
+			next_index = position;
+			++next;
+			return true;
+		}
+	};
+}  // namespace
+
+namespace {
+	// 把已经读好的句子包装成终结符来源
+	TokenSource sentence_source(const std::vector<Symbol>& sentence)
+	{
+		size_t index = 0;
+		return [&sentence, index]() mutable {
+			if (index < sentence.size()) return sentence[index++];
+			return sentence.empty() ? Symbol() : sentence.back();
+		};
+	}
+}  // namespace
+
+bool LR1Parser::parse(const std::vector<Symbol>& sentence, SemanticTreeNode*& root, Arena& arena) const
+{
+	return parse(sentence_source(sentence), root, arena);
+}
+
+bool LR1Parser::parse(const std::vector<Symbol>& sentence, CompactTree& tree) const
+{
+	return parse(sentence_source(sentence), tree);
+}
+
+bool LR1Parser::parse(const TokenSource& next_token, SemanticTreeNode*& root, Arena& arena) const
+{
+	PointerTreeBuilder builder{arena};
+	return run_parse(next_token, builder, root, static_cast<NoSubtreeReuse*>(nullptr));
+}
+
+bool LR1Parser::parse(const TokenSource& next_token, SemanticTreeNode*& root, Arena& arena, const SemanticAction& on_reduce) const
+{
+	PointerTreeBuilder builder{arena, &on_reduce};
+	return run_parse(next_token, builder, root, static_cast<NoSubtreeReuse*>(nullptr));
+}
+
+bool LR1Parser::parse(const TokenSource& next_token,
+                      const std::vector<SemanticAction>& actions,
+                      const SemanticAction& on_shift,
+                      SemanticTreeNode*& root,
+                      Arena& arena,
+                      bool keep_tree) const
+{
+	TranslatingTreeBuilder builder{arena, actions, on_shift, keep_tree, {}};
+	return run_parse(next_token, builder, root, static_cast<NoSubtreeReuse*>(nullptr));
+}
+
+bool LR1Parser::parse(const TokenSource& next_token, CompactTree& tree) const
+{
+	tree.clear();
+	CompactTreeBuilder builder{tree};
+	uint32_t root;
+	return run_parse(next_token, builder, root, static_cast<NoSubtreeReuse*>(nullptr));
+}
+
+bool LR1Parser::reparse(const std::vector<Symbol>& sentence,
+                        SemanticTreeNode* old_root,
+                        const TokenEdit& edit,
+                        SemanticTreeNode*& root,
+                        Arena& arena) const
+{
+	size_t index = 0;
+	TokenSource next_token = [&sentence, &index]() {
+		if (index < sentence.size()) return sentence[index++];
+		return sentence.empty() ? Symbol() : sentence.back();
+	};
+
+	SubtreeReuseCursor cursor{productions, edit, index, {}};
+	if (old_root != nullptr) cursor.pending.push_back(old_root);
+
+	PointerTreeBuilder builder{arena};
+	return run_parse(next_token, builder, root, &cursor);
+}
+
+bool LR1Parser::unit_start_states(const std::vector<Symbol>& sentence,
+                                  const std::vector<size_t>& boundaries,
+                                  const Symbol& unit,
+                                  std::vector<int>& states) const
+{
+	std::vector<int> stack = {0};
+	for (size_t i = 0; i + 1 < boundaries.size(); ++i) {
+		// 以段首 token 为向前看符号，先完成所有归约，直到可以移进
+		const Symbol& lookahead = sentence[boundaries[i]];
+		while (true) {
+			auto actionIt = actionTable.find({stack.back(), lookahead});
+			if (actionIt == actionTable.end()) return false;
+
+			const Action& action = actionIt->second;
+			if (action.type == Action::Type::SHIFT) break;
+			if (action.type != Action::Type::REDUCE) return false;
+
+			size_t count = action.production.rhs.size();
+			if (count >= stack.size()) return false;
+			stack.resize(stack.size() - count);
+			auto gotoIt = gotoTable.find({stack.back(), action.production.lhs});
+			if (gotoIt == gotoTable.end()) return false;
+			stack.push_back(gotoIt->second);
+		}
+
+		states.push_back(stack.back());
+		auto gotoIt = gotoTable.find({stack.back(), unit});
+		if (gotoIt == gotoTable.end()) return false;
+		stack.push_back(gotoIt->second);
+	}
+	return true;
+}
+
+bool LR1Parser::parse_parallel(const std::vector<Symbol>& sentence,
+                               const std::vector<size_t>& boundaries,
+                               const Symbol& unit,
+                               SemanticTreeNode*& root,
+                               Arena& arena,
+                               ThreadPool& pool) const
+{
+	size_t count = boundaries.size() < 2 ? 0 : boundaries.size() - 1;
+	std::vector<int> states;
+	if (count < 2 || boundaries.back() >= sentence.size() || !unit_start_states(sentence, boundaries, unit, states)) {
+		return parse(sentence, root, arena);
+	}
+
+	// 相邻的若干段合成一个任务，每个任务使用自己的 arena(Arena 不是线程安全的)，这些 arena 本身放在 arena 中
+	size_t per_task = std::max<size_t>(1, count / (pool.size() * 4));
+	size_t tasks = (count + per_task - 1) / per_task;
+	std::vector<Arena*> arenas;
+	for (size_t t = 0; t < tasks; ++t) {
+		arenas.push_back(arena.create<Arena>());
+	}
+
+	std::vector<SemanticTreeNode*> fragments(count, nullptr);
+	pool.parallel_for(tasks, [&](size_t t) {
+		for (size_t i = t * per_task; i < std::min(count, (t + 1) * per_task); ++i) {
+			// 段内的 token，之后是下一段的第一个 token(或终止符)作为向前看符号；
+			// 如果还要继续读，说明这一段不是一个完整的 unit，返回一个不存在的终结符使分析失败
+			size_t begin = boundaries[i], end = boundaries[i + 1];
+			size_t index = begin;
+			TokenSource next_token = [&sentence, &index, end]() {
+				if (index <= end) return sentence[index++];
+				return Symbol(SymbolType::Terminal, "");
+			};
+
+			PointerTreeBuilder builder{*arenas[t], nullptr, static_cast<uint32_t>(begin)};
+			ParseGoal goal{states[i], unit};
+			SemanticTreeNode* fragment = nullptr;
+			if (run_parse(next_token, builder, fragment, static_cast<NoSubtreeReuse*>(nullptr), &goal)) {
+				fragments[i] = fragment;
+			}
+		}
+		PARSE_STATS_FLUSH();
+	});
+
+	// 顺序扫描一遍，把各段的子树整体移进
+	size_t index = 0;
+	TokenSource next_token = [&sentence, &index]() {
+		if (index < sentence.size()) return sentence[index++];
+		return sentence.back();
+	};
+	FragmentCursor cursor{boundaries, fragments, unit, index};
+	PointerTreeBuilder builder{arena};
+	return run_parse(next_token, builder, root, &cursor);
+}
+
+template <typename TreeBuilder, typename SubtreeSource>
+bool LR1Parser::run_parse(const TokenSource& next_token,
+                          TreeBuilder& builder,
+                          typename TreeBuilder::Node& root,
+                          SubtreeSource* subtrees,
+                          const ParseGoal* goal) const
+{
+	using Node = typename TreeBuilder::Node;
+
+	std::stack<int> stateStack;      // 状态栈
+	std::stack<Symbol> symbolStack;  // 符号栈
+
+	std::vector<Node> nodeStack;  // 解析树结点栈
+
+	PARSE_STATS_PHASE("parse");
+	auto read_token = [&next_token]() {
+		PARSE_STATS_PHASE("lex");
+		return next_token();
+	};
+
+	// 初始状态
+	stateStack.push(goal != nullptr ? goal->start_state : 0);
+
+	// 向前看符号，移进后才读取下一个
+	Symbol currentSymbol = read_token();
+	uint32_t position = 0;  // 向前看符号在 token 序列中的下标
+
+	while (true) {
+		int currentState = stateStack.top();
+		PARSE_STATS_STATE(currentState, stateStack.size());
+
+		// 打印当前栈的状态
+		// print_stacks(stateStack, symbolStack, currentSymbol);
+
+		auto actionIt = actionTable.find({currentState, currentSymbol});
+		if (actionIt != actionTable.end()) {
+			const Action& action = actionIt->second;
+
+			switch (action.type) {
+				case Action::Type::SHIFT: {
+					// 增量分析：当前位置有可复用的旧子树时，整棵子树当作一个非终结符移进
+					Node reused;
+					Symbol lhs;
+					if (subtrees != nullptr && subtrees->try_reuse(currentState, position, reused, lhs)) {
+						stateStack.push(gotoTable.at({currentState, lhs}));
+						symbolStack.push(lhs);
+						nodeStack.push_back(reused);
+
+						currentSymbol = read_token();
+						break;
+					}
+
+					stateStack.push(action.number);
+					symbolStack.push(currentSymbol);
+
+					PARSE_STATS_SHIFT(currentSymbol.literal);
+
+					// 创建一个新的叶子节点并压入节点栈
+					nodeStack.push_back(builder.leaf(currentSymbol, currentState, position));
+
+					currentSymbol = read_token();
+					++position;
+					break;
+				}
+				case Action::Type::REDUCE: {
+					PARSE_STATS_REDUCE(action.number);
+
+					// 根据产生式右侧的长度，从栈中弹出相应数量的符号和状态
+					size_t count = action.production.rhs.size();
+					// 只分析一段句子时，归约不能越过起始状态
+					if (goal != nullptr && count >= stateStack.size()) return false;
+					for (size_t i = 0; i < count; ++i) {
+						symbolStack.pop();
+						stateStack.pop();
+					}
+
+					// 可省略的单产生式：栈顶的子结点直接充当左部结点
+					if (!(elide_unit_reductions && action.production.elide)) {
+						// 栈顶的 count 个结点即新结点的子结点
+						Node newNode = builder.reduce(action.number,
+						                              action.production,
+						                              nodeStack.data() + nodeStack.size() - count,
+						                              count,
+						                              stateStack.top(),
+						                              position);
+						nodeStack.resize(nodeStack.size() - count);
+						nodeStack.push_back(newNode);
+					}
+
+					if (goal != nullptr && stateStack.size() == 1 && action.production.lhs == goal->symbol) {
+						root = nodeStack.back();
+						return true;
+					}
+
+					// 将产生式左侧的非终结符压入符号栈
+					symbolStack.push(action.production.lhs);
+
+					// 更新状态栈
+					int nextState = gotoTable.at({stateStack.top(), action.production.lhs});
+					stateStack.push(nextState);
+					break;
+				}
+				case Action::Type::ACCEPT:
+					// 分析器可能被多个线程同时使用，接受时不再输出，由调用者根据返回值报告
+					root = nodeStack.back();  // 设置解析树的根
+					return true;
+				default:
+					if (goal == nullptr) error_stream() << "Parse error\n";
+					return false;
+			}
+		} else {
+			if (goal != nullptr) return false;
+			// 整条消息一次写出，多个线程同时报错时不会交错
+			error_stream() << "Parse error: no action at token " + std::to_string(position) + " (" + currentSymbol.literal + " " +
+			                 currentSymbol.real_value + ")\n";
+			return false;
+		}
+	}
+}
+
+void LR1Parser::print_stacks(const std::stack<int>& stateStack,
+                             const std::stack<Symbol>& symbolStack,
+                             const Symbol& lookahead) const
+{
+	// 使用向量来反转栈的内容
+	std::vector<int> reversedStateStack;
+	std::vector<Symbol> reversedSymbolStack;
+
+	// 从栈中复制到向量
+	auto tempStateStack = stateStack;
+	while (!tempStateStack.empty()) {
+		reversedStateStack.push_back(tempStateStack.top());
+		tempStateStack.pop();
+	}
+
+	auto tempSymbolStack = symbolStack;
+	while (!tempSymbolStack.empty()) {
+		reversedSymbolStack.push_back(tempSymbolStack.top());
+		tempSymbolStack.pop();
+	}
+
+	// 逆序打印向量，从而按栈底到栈顶的顺序输出
+	std::cout << "State Stack: ";
+	for (auto it = reversedStateStack.rbegin(); it != reversedStateStack.rend(); ++it) {
+		std::cout << *it << " ";
+	}
+	std::cout << "\n";
+
+	std::cout << "Symbol Stack: ";
+	for (auto it = reversedSymbolStack.rbegin(); it != reversedSymbolStack.rend(); ++it) {
+		std::cout << it->to_string() << " ";
+	}
+	std::cout << "\n";
+
+	std::cout << "Lookahead: " << lookahead.to_string() << "\n"
+	          << std::endl;
+}
+
+bool LR1Parser::save_tables(const std::string& file_path)
+{
+	std::ofstream fout(file_path);
+	if (!fout.is_open()) return false;
+
+	// 序列化 actionTable
+	for (auto& item : actionTable) {
+		int t1 = item.first.first;
+		Symbol t2 = item.first.second;
+		Action t3 = item.second;
+		fout << t1 << " " << t2 << " " << t3 << "" << std::endl;
+	}
+
+	// 可能需要一个分隔符来区分两个表
+	fout << "---" << std::endl;
+
+	// 序列化 gotoTable
+	for (auto& item : gotoTable) {
+		int t1 = item.first.first;
+		Symbol t2 = item.first.second;
+		int t3 = item.second;
+		fout << t1 << " " << t2 << " " << t3 << "" << std::endl;
+	}
+
+	fout.close();
+	return true;
+}
+
+bool LR1Parser::load_tables(const std::string& file_path)
+{
+	std::ifstream fin(file_path);
+	if (!fin.is_open()) return false;
+
+	std::string line;
+	bool readingActionTable = true;  // 初始假设从actionTable开始读取
+
+	productions.clear();
+
+	while (std::getline(fin, line)) {
+		// table.cache 可能以 CRLF 换行保存，去掉行尾的 '\r'
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (line == "---") {
+			// 遇到分隔符，切换到读取 gotoTable
+			readingActionTable = false;
+			continue;
+		}
+		std::istringstream iss(line);
+		int state;
+		Symbol symbol;
+		iss >> state >> symbol;
+
+		if (readingActionTable) {
+			Action action;
+			iss >> action;
+			actionTable[{state, symbol}] = action;
+
+			// 缓存中没有单独的产生式表，由归约/接受动作中的产生式编号还原
+			if (action.type == Action::Type::REDUCE || action.type == Action::Type::ACCEPT) {
+				if (productions.size() <= action.number) productions.resize(action.number + 1);
+				productions[action.number] = action.production;
+			}
+		} else {
+			int gotoState;
+			iss >> gotoState;
+			gotoTable[{state, symbol}] = gotoState;
+		}
+	}
+
+	fin.close();
+	return true;
+}
+
+// int main()
+// {
+// 	// 定义非终结符
+// 	Symbol S(SymbolType::NonTerminal, "S");
+// 	Symbol B(SymbolType::NonTerminal, "B");
+// 	Symbol S_prime(SymbolType::NonTerminal, "S'");
+
+// 	// 定义终结符
+// 	Symbol a(SymbolType::Terminal, "a");
+// 	Symbol b(SymbolType::Terminal, "b");
+
+// 	// 定义产生式
+// 	Production p1(S_prime, {S});
+// 	Production p2(S, {B, B});
+// 	Production p3(B, {a, B});
+// 	Production p4(B, {b});
+
+// 	// std::vector<Production> productions = {p1, p2, p3, p4};
+
+// 	// // 创建LR1解析器实例
+// 	// LR1Parser parser(productions, S_prime, Symbol(SymbolType::Terminal, "$"));
+// 	LR1Parser parser("grammer.txt");
+
+// 	parser.print_firstSet();
+// 	parser.print_tables();
+
+// 	// std::vector<Symbol> sentence = {a, b, a, b, Symbol(SymbolType::Terminal, "$")};
+// 	// parser.parse(sentence);
+
+// 	return 0;
 // }
\ No newline at end of file
@@ -1,406 +1,516 @@
-#pragma once
-
-#include <string>
-#include <set>
-#include <vector>
-#include <map>
-#include <stack>
-#include <algorithm>
-#include <fstream>
-#include <sstream>
-#include <unordered_set>
-#include <unordered_map>
-#include <iostream>
-#include "Quater.hpp"
-
-
-enum class SymbolType {
-	Terminal,     // 终结符
-	NonTerminal,  // 非终结符
-	Epsilon       // 空串
-};
-
-class Symbol {
-public:
-	SymbolType type;         // 终结符/非终结符/空串
-	std::string literal;     // 这个符号的字面量，比如一个非终结符名为 S,A,B e.g.一个终结符名为T_INT,T_xxxx
-	std::string real_value;  // 这个符号的真实值，比如一个变量名a，一个int数值3
-
-	Symbol(const SymbolType& type = SymbolType::Epsilon,
-	       const std::string& literal = "",
-	       const std::string& real_value = "")
-	    : type(type), literal(literal), real_value(real_value) {}
-
-
-	std::string to_string() const
-	{
-		return literal;  // 或者任何合适的表示方式
-	}
-
-	friend bool operator==(const Symbol& lhs, const Symbol& rhs)
-	{
-		return lhs.type == rhs.type && lhs.literal == rhs.literal;
-		// && lhs.real_value == rhs.real_value;
-	}
-
-	friend bool operator<(const Symbol& lhs, const Symbol& rhs)
-	{
-		if (lhs.type != rhs.type) {
-			return lhs.type < rhs.type;
-		}
-		// if (lhs.literal != rhs.literal) {
-		return lhs.literal < rhs.literal;
-		// }
-		// return lhs.real_value < rhs.real_value;
-	}
-
-	friend std::ostream& operator<<(std::ostream& os, Symbol& symbol)
-	{
-		if (symbol.type == SymbolType::Epsilon) {
-			return os << static_cast<int>(symbol.type);
-		}
-		return os << static_cast<int>(symbol.type) << " " << symbol.literal << " "
-		          << (symbol.real_value.empty() ? "NULL" : symbol.real_value);
-	}
-	friend std::istream& operator>>(std::istream& is, Symbol& symbol)
-	{
-		int temp;
-		is >> temp;
-		symbol.type = static_cast<SymbolType>(temp);
-		if (symbol.type == SymbolType::Epsilon) {
-			return is;
-		}
-
-		is >> symbol.literal >> symbol.real_value;
-		if (symbol.real_value == "NULL") symbol.real_value = "";
-		return is;
-	}
-};
-
-struct Production
-{
-	Symbol lhs;               // 左手边，非终结符
-	std::vector<Symbol> rhs;  // 右手边，非终结符和终结符的 组合
-
-	Production() {}
-	Production(Symbol lhs, std::vector<Symbol> rhs) : lhs(lhs), rhs(rhs) {}
-	std::string to_string() const
-	{
-		std::string res;
-		res += lhs.literal + " -> ";
-		for (auto& item : rhs) {
-			res += item.literal;
-		}
-		return "[" + res + "]";
-	}
-
-	friend bool operator==(const Production& lhs, const Production& rhs)
-	{
-		return lhs.lhs == rhs.lhs && lhs.rhs == rhs.rhs;
-	}
-	friend bool operator<(const Production& lhs, const Production& rhs)
-	{
-		if (lhs.lhs < rhs.lhs) return true;
-		if (rhs.lhs < lhs.lhs) return false;
-		return lhs.rhs < rhs.rhs;
-	}
-
-	friend std::ostream& operator<<(std::ostream& os, Production& production)
-	{
-		os << production.lhs << " " << production.rhs.size();
-		for (auto& symbol : production.rhs) {
-			os << " " << symbol;
-		}
-		return os;
-	}
-
-	friend std::istream& operator>>(std::istream& is, Production& production)
-	{
-		size_t size;
-		is >> production.lhs >> size;
-		production.rhs.clear();
-		Symbol symbol;
-		for (size_t i = 0; i < size; ++i) {
-			is >> symbol;
-			production.rhs.push_back(symbol);
-		}
-		return is;
-	}
-};
-
-class LR1Item {
-public:
-	enum class State {
-		SHIFT,   // 移进
-		REDUCE,  // 归约
-		GOTO,    // 待约
-		ACCEPT   // 接受
-	};
-
-	LR1Item(Production production, size_t dot_position, Symbol lookahead)
-	    : production(production), dot_position(dot_position), lookahead(lookahead) {}
-
-	std::string to_string() const
-	{
-		std::string res;
-		res += production.lhs.literal + " -> ";
-		size_t index = 0;
-		for (auto& item : production.rhs) {
-			if (index++ == dot_position) res += ".";
-			res += item.literal;
-		}
-		if (index++ == dot_position) res += ".";
-		res += ", " + lookahead.literal;
-		return "[" + res + "]";
-	}
-
-	Symbol next_symbol() const
-	{
-		if (dot_position == production.rhs.size()) return Symbol(SymbolType::Epsilon, "");
-		return production.rhs[dot_position];
-	}
-
-	Symbol nnext_symbol() const
-	{
-		if (dot_position == production.rhs.size()) return Symbol(SymbolType::Epsilon, "");
-
-		LR1Item tmp = *this;
-		tmp.dot_position++;
-		return tmp.next_symbol();
-	}
-
-	Production production;
-	size_t dot_position;
-	Symbol lookahead;
-
-	friend bool operator==(const LR1Item& lhs, const LR1Item& rhs)
-	{
-		return lhs.production == rhs.production &&
-		       lhs.dot_position == rhs.dot_position &&
-		       lhs.lookahead == rhs.lookahead;
-	}
-
-	friend bool operator<(const LR1Item& lhs, const LR1Item& rhs)
-	{
-		if (lhs.production < rhs.production) return true;
-		if (rhs.production < lhs.production) return false;
-		if (lhs.dot_position < rhs.dot_position) return true;
-		if (rhs.dot_position < lhs.dot_position) return false;
-		return lhs.lookahead < rhs.lookahead;
-	}
-};
-
-struct Action
-{
-	enum class Type {
-		SHIFT,
-		REDUCE,
-		ACCEPT,
-		ERROR
-	};
-	Type type;
-	size_t number;          // shift的新状态编号
-	Production production;  // reduce使用的产生式
-
-	Action() {}
-	Action(const Type& type, const size_t& number, const Production& production) : type(type), number(number), production(production) {}
-
-	std::string to_string() const
-	{
-		switch (type) {
-			case Type::SHIFT:
-				return "S " + std::to_string(number);
-			case Type::REDUCE:
-				return "R " + production.to_string();
-			case Type::ACCEPT:
-				return "Accept";
-			case Type::ERROR:
-				return "x";
-		}
-		return "";
-	}
-
-
-	friend std::ostream& operator<<(std::ostream& os, Action::Type& type)
-	{
-		return os << static_cast<int>(type);
-	}
-
-	friend std::istream& operator>>(std::istream& is, Action::Type& type)
-	{
-		int intType;
-		is >> intType;
-		type = static_cast<Type>(intType);
-		return is;
-	}
-
-
-	friend std::ostream& operator<<(std::ostream& os, Action& action)
-	{
-		return os << action.type << " " << action.number << " " << action.production;
-	}
-
-	friend std::istream& operator>>(std::istream& is, Action& action)
-	{
-		int temp;
-		is >> temp >> action.number >> action.production;
-		action.type = static_cast<Type>(temp);
-		return is;
-	}
-};
-
-
-struct SymbolHash
-{
-	size_t operator()(const Symbol& sym) const
-	{
-		size_t h1 = std::hash<std::string>()(sym.literal);
-		// size_t h2 = std::hash<std::string>()(sym.real_value);
-		size_t h3 = std::hash<int>()(static_cast<int>(sym.type));
-
-		return h1 ^ h3;  // Combine and mix the hashes
-	}
-};
-
-struct SymbolEqual
-{
-	bool operator()(const Symbol& lhs, const Symbol& rhs) const
-	{
-		return lhs.type == rhs.type &&
-		       lhs.literal == rhs.literal;
-		//    && lhs.real_value == rhs.real_value;
-	}
-};
-
-struct ProductionHash
-{
-	size_t operator()(const Production& prod) const
-	{
-		size_t hash = SymbolHash()(prod.lhs);
-		for (const auto& sym : prod.rhs) {
-			hash ^= SymbolHash()(sym) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-		}
-		return hash;
-	}
-};
-
-struct ProductionEqual
-{
-	bool operator()(const Production& lhs, const Production& rhs) const
-	{
-		if (!SymbolEqual()(lhs.lhs, rhs.lhs) || lhs.rhs.size() != rhs.rhs.size()) {
-			return false;
-		}
-		for (size_t i = 0; i < lhs.rhs.size(); ++i) {
-			if (!SymbolEqual()(lhs.rhs[i], rhs.rhs[i])) {
-				return false;
-			}
-		}
-		return true;
-	}
-};
-
-// 自定义哈希函数
-struct LR1ItemHash
-{
-	size_t operator()(const LR1Item& item) const
-	{
-		return ProductionHash()(item.production) ^ std::hash<size_t>()(item.dot_position) ^ SymbolHash()(item.lookahead);
-	}
-};
-
-// 自定义相等比较函数
-struct LR1ItemEqual
-{
-	bool operator()(const LR1Item& lhs, const LR1Item& rhs) const
-	{
-		return ProductionEqual()(lhs.production, rhs.production) && lhs.dot_position == rhs.dot_position && SymbolEqual()(lhs.lookahead, rhs.lookahead);
-	}
-};
-
-class SemanticTreeNode : public Symbol {
-public:
-	SemanticTreeNode(const Symbol& sym) : Symbol(sym), next_quater_id(0) {}
-	bool leaf() { return children.empty(); }
-
-	// 返回添加四元式的ID
-	size_t add_quater(const Quater& quater);
-	size_t add_quater(const size_t& base_id, const Quater& quater);
-	size_t add_quater(const std::string& op, const std::string& arg1, const std::string& arg2, const std::string& result);
-	size_t add_quater(const std::string& op, const std::string& arg1, const std::string& arg2, const size_t& result);
-
-	// 追加一个quaters进来
-	void append_quaters(const std::vector<std::pair<size_t, Quater>>& quaters);
-
-public:
-	std::vector<SemanticTreeNode*> children;
-	std::vector<std::pair<size_t, Quater>> quater_list;
-
-private:
-	size_t next_quater_id;
-};
-
-class LR1Parser {
-public:
-	LR1Parser(const std::vector<Production>& productions, Symbol start, Symbol end);
-	LR1Parser(const std::string file_path);
-	LR1Parser() {}
-
-	void print_firstSet() const;
-	void print_tables() const;
-	bool parse(const std::vector<Symbol>& sentence, SemanticTreeNode*& root) const;
-	void save_tables(const std::string& file_path);
-	void load_tables(const std::string& file_path);
-
-private:
-	void
-	parse_EBNF_line(const std::string& line);
-	void print_stacks(const std::stack<int>& stateStack,
-	                  const std::stack<Symbol>& symbolStack,
-	                  const std::vector<Symbol>& inputStack) const;
-
-	void construct_tables();
-	/**
-	 * @brief 求项目集族的闭包
-	 *
-	 * @param lr1ItemSet 待求闭包的项目集族
-	 * @return std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual> 该项目集族的闭包
-	 */
-	void closure(std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual>& lr1ItemSet) const;
-
-private:
-	/**
-	 * @brief 获取一个LR1项目当前的状态(移进、归约、接受、待约)
-	 *
-	 * @param item LR1项目
-	 * @return LR1Item::State 状态
-	 */
-	LR1Item::State get_lr1item_state(const LR1Item& item) const;
-
-	/**
-	 * @brief 获取由某非终结符为产生式左边的所有产生式
-	 *
-	 * @param symbol 非终结符
-	 * @return std::vector<Production> 所有产生式
-	 */
-	std::vector<Production> get_productions_start_by_symbol(const Symbol& symbol) const;
-
-private:  // 求FIRST集
-	void calculate_firstSets();
-	std::unordered_set<Symbol, SymbolHash, SymbolEqual> get_first_string(std::vector<Symbol> content) const;
-
-private:
-	std::vector<Production> productions;
-	std::unordered_map<Symbol, std::vector<Production>, SymbolHash, SymbolEqual> productionMap;
-	std::unordered_map<Symbol, std::unordered_set<Symbol, SymbolHash, SymbolEqual>, SymbolHash, SymbolEqual> firstSet, followSet;
-
-	Symbol start_symbol;  // 起始符
-	Symbol end_symbol;    // 终止符
-
-
-	std::map<std::pair<int, Symbol>, Action> actionTable;                             // ACTION表
-	std::map<std::pair<int, Symbol>, int> gotoTable;                                  // GOTO表
-	std::vector<std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual>> lr1ItemSets;  // 项目集族
-
-	std::unordered_set<std::string> terminals;  // 终结符集
-};
+#pragma once
+
+#include <string>
+#include <set>
+#include <vector>
+#include <map>
+#include <stack>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+#include <unordered_map>
+#include <iostream>
+#include <functional>
+#include "IRBuffer.hpp"
+#include "Arena.hpp"
+
+
+enum class SymbolType {
+	Terminal,     // 终结符
+	NonTerminal,  // 非终结符
+	Epsilon       // 空串
+};
+
+class Symbol {
+public:
+	SymbolType type;         // 终结符/非终结符/空串
+	std::string literal;     // 这个符号的字面量，比如一个非终结符名为 S,A,B e.g.一个终结符名为T_INT,T_xxxx
+	std::string real_value;  // 这个符号的真实值，比如一个变量名a，一个int数值3
+
+	Symbol(const SymbolType& type = SymbolType::Epsilon,
+	       const std::string& literal = "",
+	       const std::string& real_value = "")
+	    : type(type), literal(literal), real_value(real_value) {}
+
+
+	std::string to_string() const
+	{
+		return literal;  // 或者任何合适的表示方式
+	}
+
+	friend bool operator==(const Symbol& lhs, const Symbol& rhs)
+	{
+		return lhs.type == rhs.type && lhs.literal == rhs.literal;
+		// && lhs.real_value == rhs.real_value;
+	}
+
+	friend bool operator<(const Symbol& lhs, const Symbol& rhs)
+	{
+		if (lhs.type != rhs.type) {
+			return lhs.type < rhs.type;
+		}
+		// if (lhs.literal != rhs.literal) {
+		return lhs.literal < rhs.literal;
+		// }
+		// return lhs.real_value < rhs.real_value;
+	}
+
+	friend std::ostream& operator<<(std::ostream& os, Symbol& symbol)
+	{
+		if (symbol.type == SymbolType::Epsilon) {
+			return os << static_cast<int>(symbol.type);
+		}
+		return os << static_cast<int>(symbol.type) << " " << symbol.literal << " "
+		          << (symbol.real_value.empty() ? "NULL" : symbol.real_value);
+	}
+	friend std::istream& operator>>(std::istream& is, Symbol& symbol)
+	{
+		int temp;
+		is >> temp;
+		symbol.type = static_cast<SymbolType>(temp);
+		if (symbol.type == SymbolType::Epsilon) {
+			return is;
+		}
+
+		is >> symbol.literal >> symbol.real_value;
+		if (symbol.real_value == "NULL") symbol.real_value = "";
+		return is;
+	}
+};
+
+struct Production
+{
+	Symbol lhs;               // 左手边，非终结符
+	std::vector<Symbol> rhs;  // 右手边，非终结符和终结符的 组合
+	bool elide = false;       // 单产生式且语义动作只是透传，允许归约时不建新结点(文法中以 @elide 标记)
+
+	Production() {}
+	Production(Symbol lhs, std::vector<Symbol> rhs) : lhs(lhs), rhs(rhs) {}
+	std::string to_string() const
+	{
+		std::string res;
+		res += lhs.literal + " -> ";
+		for (auto& item : rhs) {
+			res += item.literal;
+		}
+		return "[" + res + "]";
+	}
+
+	friend bool operator==(const Production& lhs, const Production& rhs)
+	{
+		return lhs.lhs == rhs.lhs && lhs.rhs == rhs.rhs;
+	}
+	friend bool operator<(const Production& lhs, const Production& rhs)
+	{
+		if (lhs.lhs < rhs.lhs) return true;
+		if (rhs.lhs < lhs.lhs) return false;
+		return lhs.rhs < rhs.rhs;
+	}
+
+	friend std::ostream& operator<<(std::ostream& os, Production& production)
+	{
+		os << production.lhs << " " << production.rhs.size();
+		for (auto& symbol : production.rhs) {
+			os << " " << symbol;
+		}
+		return os << " " << production.elide;
+	}
+
+	friend std::istream& operator>>(std::istream& is, Production& production)
+	{
+		size_t size;
+		is >> production.lhs >> size;
+		production.rhs.clear();
+		Symbol symbol;
+		for (size_t i = 0; i < size; ++i) {
+			is >> symbol;
+			production.rhs.push_back(symbol);
+		}
+		is >> production.elide;
+		return is;
+	}
+};
+
+class LR1Item {
+public:
+	enum class State {
+		SHIFT,   // 移进
+		REDUCE,  // 归约
+		GOTO,    // 待约
+		ACCEPT   // 接受
+	};
+
+	LR1Item(Production production, size_t dot_position, Symbol lookahead)
+	    : production(production), dot_position(dot_position), lookahead(lookahead) {}
+
+	std::string to_string() const
+	{
+		std::string res;
+		res += production.lhs.literal + " -> ";
+		size_t index = 0;
+		for (auto& item : production.rhs) {
+			if (index++ == dot_position) res += ".";
+			res += item.literal;
+		}
+		if (index++ == dot_position) res += ".";
+		res += ", " + lookahead.literal;
+		return "[" + res + "]";
+	}
+
+	Symbol next_symbol() const
+	{
+		if (dot_position == production.rhs.size()) return Symbol(SymbolType::Epsilon, "");
+		return production.rhs[dot_position];
+	}
+
+	Symbol nnext_symbol() const
+	{
+		if (dot_position == production.rhs.size()) return Symbol(SymbolType::Epsilon, "");
+
+		LR1Item tmp = *this;
+		tmp.dot_position++;
+		return tmp.next_symbol();
+	}
+
+	Production production;
+	size_t dot_position;
+	Symbol lookahead;
+
+	friend bool operator==(const LR1Item& lhs, const LR1Item& rhs)
+	{
+		return lhs.production == rhs.production &&
+		       lhs.dot_position == rhs.dot_position &&
+		       lhs.lookahead == rhs.lookahead;
+	}
+
+	friend bool operator<(const LR1Item& lhs, const LR1Item& rhs)
+	{
+		if (lhs.production < rhs.production) return true;
+		if (rhs.production < lhs.production) return false;
+		if (lhs.dot_position < rhs.dot_position) return true;
+		if (rhs.dot_position < lhs.dot_position) return false;
+		return lhs.lookahead < rhs.lookahead;
+	}
+};
+
+struct Action
+{
+	enum class Type {
+		SHIFT,
+		REDUCE,
+		ACCEPT,
+		ERROR
+	};
+	Type type;
+	size_t number;          // shift的新状态编号；reduce/accept使用的产生式编号
+	Production production;  // reduce使用的产生式
+
+	Action() {}
+	Action(const Type& type, const size_t& number, const Production& production) : type(type), number(number), production(production) {}
+
+	std::string to_string() const
+	{
+		switch (type) {
+			case Type::SHIFT:
+				return "S " + std::to_string(number);
+			case Type::REDUCE:
+				return "R " + production.to_string();
+			case Type::ACCEPT:
+				return "Accept";
+			case Type::ERROR:
+				return "x";
+		}
+		return "";
+	}
+
+
+	friend std::ostream& operator<<(std::ostream& os, Action::Type& type)
+	{
+		return os << static_cast<int>(type);
+	}
+
+	friend std::istream& operator>>(std::istream& is, Action::Type& type)
+	{
+		int intType;
+		is >> intType;
+		type = static_cast<Type>(intType);
+		return is;
+	}
+
+
+	friend std::ostream& operator<<(std::ostream& os, Action& action)
+	{
+		return os << action.type << " " << action.number << " " << action.production;
+	}
+
+	friend std::istream& operator>>(std::istream& is, Action& action)
+	{
+		int temp;
+		is >> temp >> action.number >> action.production;
+		action.type = static_cast<Type>(temp);
+		return is;
+	}
+};
+
+
+struct SymbolHash
+{
+	size_t operator()(const Symbol& sym) const
+	{
+		size_t h1 = std::hash<std::string>()(sym.literal);
+		// size_t h2 = std::hash<std::string>()(sym.real_value);
+		size_t h3 = std::hash<int>()(static_cast<int>(sym.type));
+
+		return h1 ^ h3;  // Combine and mix the hashes
+	}
+};
+
+struct SymbolEqual
+{
+	bool operator()(const Symbol& lhs, const Symbol& rhs) const
+	{
+		return lhs.type == rhs.type &&
+		       lhs.literal == rhs.literal;
+		//    && lhs.real_value == rhs.real_value;
+	}
+};
+
+struct ProductionHash
+{
+	size_t operator()(const Production& prod) const
+	{
+		size_t hash = SymbolHash()(prod.lhs);
+		for (const auto& sym : prod.rhs) {
+			hash ^= SymbolHash()(sym) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		}
+		return hash;
+	}
+};
+
+struct ProductionEqual
+{
+	bool operator()(const Production& lhs, const Production& rhs) const
+	{
+		if (!SymbolEqual()(lhs.lhs, rhs.lhs) || lhs.rhs.size() != rhs.rhs.size()) {
+			return false;
+		}
+		for (size_t i = 0; i < lhs.rhs.size(); ++i) {
+			if (!SymbolEqual()(lhs.rhs[i], rhs.rhs[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+// 自定义哈希函数
+struct LR1ItemHash
+{
+	size_t operator()(const LR1Item& item) const
+	{
+		return ProductionHash()(item.production) ^ std::hash<size_t>()(item.dot_position) ^ SymbolHash()(item.lookahead);
+	}
+};
+
+// 自定义相等比较函数
+struct LR1ItemEqual
+{
+	bool operator()(const LR1Item& lhs, const LR1Item& rhs) const
+	{
+		return ProductionEqual()(lhs.production, rhs.production) && lhs.dot_position == rhs.dot_position && SymbolEqual()(lhs.lookahead, rhs.lookahead);
+	}
+};
+
+class SemanticTreeNode;
+
+// 结点的子结点数组，数组本身分配在 Arena 中
+struct ChildList
+{
+	SemanticTreeNode** data = nullptr;
+	size_t count = 0;
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	SemanticTreeNode*& operator[](size_t i) const { return data[i]; }
+	SemanticTreeNode** begin() const { return data; }
+	SemanticTreeNode** end() const { return data + count; }
+};
+
+class SemanticTreeNode : public Symbol {
+public:
+	SemanticTreeNode(const Symbol& sym) : Symbol(sym) {}
+	bool leaf() { return children.empty(); }
+
+public:
+	ChildList children;
+	IRCode code;    // 这棵子树的中间代码，四元式本身在语义分析器的 IRBuffer 中
+	Opcode op = Opcode::COUNT;  // relop、addop 等运算符结点代表的运算
+	Operand place;  // 表达式的值所在的操作数(变量、临时变量、常量或复合操作数)
+
+	// 增量分析用：结点覆盖的 token 范围 [token_begin, token_end)，创建它的产生式编号，
+	// 以及开始分析该结点(移进它的第一个 token)时栈顶的状态
+	uint32_t token_begin = 0;
+	uint32_t token_end = 0;
+	size_t production_id = -1;
+	int start_state = -1;
+	bool analyzed = false;  // 语义属性(place、op、code)已经算好，复用时不必重新分析
+};
+
+// 一次编辑在 token 序列上的范围：旧序列的 [begin, old_end) 被替换为新序列的 [begin, new_end)
+struct TokenEdit
+{
+	size_t begin;
+	size_t old_end;
+	size_t new_end;
+};
+
+class CompactTree;
+class ThreadPool;
+
+// 终结符来源：每次调用返回下一个终结符，输入结束后一直返回终止符
+using TokenSource = std::function<Symbol()>;
+
+// 语义动作：归约时对新建的结点执行，此时它的子结点都已处理完毕
+using SemanticAction = std::function<void(SemanticTreeNode* node)>;
+
+class LR1Parser {
+public:
+	LR1Parser(const std::vector<Production>& productions, Symbol start, Symbol end);
+	LR1Parser(const std::string file_path);
+	LR1Parser() {}
+
+	// 开启后，标记了 @elide 的单产生式归约时直接复用子结点，不再创建新结点
+	void set_elide_unit_reductions(bool enable) { elide_unit_reductions = enable; }
+
+	void print_firstSet() const;
+	void print_tables() const;
+	// 语法树结点全部分配在 arena 中，随 arena 一起释放
+	bool parse(const std::vector<Symbol>& sentence, SemanticTreeNode*& root, Arena& arena) const;
+	// 输出按后序存放的紧凑语法树
+	bool parse(const std::vector<Symbol>& sentence, CompactTree& tree) const;
+	// 从 next_token 按需拉取终结符，只在移进时才读取下一个
+	bool parse(const TokenSource& next_token, SemanticTreeNode*& root, Arena& arena) const;
+	bool parse(const TokenSource& next_token, CompactTree& tree) const;
+	// 同上，并且每归约出一个结点就调用一次 on_reduce，此时该结点的子树已经完整，语法分析器之后不会再修改它
+	bool parse(const TokenSource& next_token, SemanticTreeNode*& root, Arena& arena, const SemanticAction& on_reduce) const;
+	// 语法制导翻译：actions 按产生式编号索引，归约时立即执行；on_shift 在每个终结符移进时执行(可以为空)
+	// keep_tree 为 false 时不保留语法树，子结点在父结点的语义动作执行后即被回收
+	bool parse(const TokenSource& next_token,
+	           const std::vector<SemanticAction>& actions,
+	           const SemanticAction& on_shift,
+	           SemanticTreeNode*& root,
+	           Arena& arena,
+	           bool keep_tree = false) const;
+
+	// 增量重新分析：旧语法树中不受编辑影响、且分析到其起点时状态相同的子树被整体复用
+	// (Wagner–Graham 式的状态匹配)，复用的子树连同其语义属性一起挂到新树上
+	// 新结点分配在 arena 中，被复用的子树仍属于旧树的 arena，需要保证其存活
+	bool reparse(const std::vector<Symbol>& sentence,
+	             SemanticTreeNode* old_root,
+	             const TokenEdit& edit,
+	             SemanticTreeNode*& root,
+	             Arena& arena) const;
+
+	// 并行分析：sentence 按 boundaries 切成若干段，第 i 段为 [boundaries[i], boundaries[i + 1])，
+	// 每段应当恰好归约为一个 unit(如顶层的 declaration)。各段在 pool 中从各自的起始状态独立分析，
+	// 再顺序扫描一遍整个句子，把分析好的段当作一个 unit 整体移进，完成外层的归约
+	// 某一段分析失败时，顺序扫描到这里会按普通方式逐个 token 分析，所以结果总与 parse 相同
+	// 调用线程会阻塞等待 pool 中的任务，不能在 pool 的工作线程中调用
+	bool parse_parallel(const std::vector<Symbol>& sentence,
+	                    const std::vector<size_t>& boundaries,
+	                    const Symbol& unit,
+	                    SemanticTreeNode*& root,
+	                    Arena& arena,
+	                    ThreadPool& pool) const;
+
+	// 语法错误信息的输出位置，只对调用线程有效，nullptr 表示 std::cerr
+	// 编译服务用它把每个请求的错误信息交还给客户端
+	static void set_error_output(std::ostream* out);
+
+	// 产生式按文法文件中的顺序编号，归约动作中记录的就是这个编号
+	const std::vector<Production>& get_productions() const { return productions; }
+	// 文件打不开时返回 false，不退出进程
+	bool save_tables(const std::string& file_path);
+	bool load_tables(const std::string& file_path);
+
+private:
+	// 分析片段的目标：并行分析时每一段从 start_state 开始，
+	// 归约出 symbol 并且栈退回 start_state 时这一段就分析完了
+	struct ParseGoal
+	{
+		int start_state;
+		Symbol symbol;
+	};
+
+	// LR(1) 分析主循环，语法树的具体形式由 TreeBuilder 决定
+	// subtrees 非空时，每次移进前先尝试从中取一棵可复用的子树
+	// goal 非空时只分析一段句子，出错时不输出错误信息，由调用者处理
+	template <typename TreeBuilder, typename SubtreeSource>
+	bool run_parse(const TokenSource& next_token,
+	               TreeBuilder& builder,
+	               typename TreeBuilder::Node& root,
+	               SubtreeSource* subtrees,
+	               const ParseGoal* goal = nullptr) const;
+
+	// 把每个 unit 看作一个终结符，模拟分析各段之间的动作，求出每一段开始时的状态
+	bool unit_start_states(const std::vector<Symbol>& sentence,
+	                       const std::vector<size_t>& boundaries,
+	                       const Symbol& unit,
+	                       std::vector<int>& states) const;
+
+	void
+	parse_EBNF_line(const std::string& line);
+	void print_stacks(const std::stack<int>& stateStack,
+	                  const std::stack<Symbol>& symbolStack,
+	                  const Symbol& lookahead) const;
+
+	void construct_tables();
+	/**
+	 * @brief 求项目集族的闭包
+	 *
+	 * @param lr1ItemSet 待求闭包的项目集族
+	 * @return std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual> 该项目集族的闭包
+	 */
+	void closure(std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual>& lr1ItemSet) const;
+
+private:
+	/**
+	 * @brief 获取一个LR1项目当前的状态(移进、归约、接受、待约)
+	 *
+	 * @param item LR1项目
+	 * @return LR1Item::State 状态
+	 */
+	LR1Item::State get_lr1item_state(const LR1Item& item) const;
+
+	/**
+	 * @brief 获取由某非终结符为产生式左边的所有产生式
+	 *
+	 * @param symbol 非终结符
+	 * @return std::vector<Production> 所有产生式
+	 */
+	std::vector<Production> get_productions_start_by_symbol(const Symbol& symbol) const;
+
+	size_t production_index(const Production& production) const;
+
+private:  // 求FIRST集
+	void calculate_firstSets();
+	std::unordered_set<Symbol, SymbolHash, SymbolEqual> get_first_string(std::vector<Symbol> content) const;
+
+private:
+	std::vector<Production> productions;
+	std::unordered_map<Symbol, std::vector<Production>, SymbolHash, SymbolEqual> productionMap;
+	std::unordered_map<Symbol, std::unordered_set<Symbol, SymbolHash, SymbolEqual>, SymbolHash, SymbolEqual> firstSet, followSet;
+
+	Symbol start_symbol;  // 起始符
+	Symbol end_symbol;    // 终止符
+
+
+	std::map<std::pair<int, Symbol>, Action> actionTable;                             // ACTION表
+	std::map<std::pair<int, Symbol>, int> gotoTable;                                  // GOTO表
+	std::vector<std::unordered_set<LR1Item, LR1ItemHash, LR1ItemEqual>> lr1ItemSets;  // 项目集族
+
+	std::unordered_set<std::string> terminals;  // 终结符集
+
+	bool elide_unit_reductions = false;
+};
@@ -0,0 +1,465 @@
+#include "Optimizer.hpp"
+#include "OutputBuffer.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+
+namespace {
+	using Kind = Operand::Kind;
+
+	// 编译时已知的数值：整数和字符常量取 integer，浮点常量取 real
+	struct Value
+	{
+		bool is_real;
+		int64_t integer;
+		float real;
+
+		float as_real() const { return is_real ? real : static_cast<float>(integer); }
+		bool truth() const { return is_real ? real != 0 : integer != 0; }
+	};
+
+	// 整数常量超出 int 的范围(目标的 int 为 32 位)、浮点常量在 float 中溢出或变为 0 时，不当作已知的值
+	bool value_of(const Interner& names, Operand operand, Value& value)
+	{
+		Kind kind = operand.kind();
+		if (kind != Kind::INT && kind != Kind::FLOAT && kind != Kind::CHAR) return false;
+		const Constant& constant = names.constant(operand.index());
+		float real = static_cast<float>(constant.real);
+		if (kind == Kind::FLOAT && (!std::isfinite(real) || (real == 0) != (constant.real == 0))) return false;
+		if (kind != Kind::FLOAT && (constant.integer < INT32_MIN || constant.integer > INT32_MAX)) return false;
+		value = Value{kind == Kind::FLOAT, constant.integer, real};
+		return true;
+	}
+
+	// 结果超出 int 的范围(有符号溢出在 C 中没有确定的结果)时不折叠
+	Operand integer_constant(Interner& names, int64_t value)
+	{
+		if (value < INT32_MIN || value > INT32_MAX) return Operand();
+		return names.constant(Kind::INT, std::to_string(value));
+	}
+
+	// 取能还原出同一个 float 值的最短写法，没有小数点时补上 .0，以免看起来像整数；溢出为无穷时不折叠
+	Operand real_constant(Interner& names, float value)
+	{
+		if (!std::isfinite(value)) return Operand();
+		char text[32];
+		for (int precision = 1; precision <= 9; ++precision) {
+			std::snprintf(text, sizeof(text), "%.*g", precision, value);
+			if (std::strtof(text, nullptr) == value) break;
+		}
+		std::string literal = text;
+		if (literal.find_first_of(".e") == std::string::npos) literal += ".0";
+		return names.constant(Kind::FLOAT, literal);
+	}
+
+	// 运算的操作数(一元运算只看 arg1)都是数值常量时算出结果；结果在编译时不能确定(除以 0、溢出、移位越界等)时返回空操作数
+	// 整数按 32 位的 int 计算，有浮点数参与时按 float 计算，关系和逻辑运算的结果为整数 0 或 1
+	Operand fold(Interner& names, Opcode op, Operand arg1, Operand arg2)
+	{
+		Value a, b;
+		if (!value_of(names, arg1, a)) return Operand();
+		if (op == Opcode::NOT) return integer_constant(names, !a.truth());
+		if (op == Opcode::BITNOT) return a.is_real ? Operand() : integer_constant(names, ~a.integer);
+		if (!value_of(names, arg2, b)) return Operand();
+
+		// 两个操作数都在 int 的范围内，按 64 位计算不会溢出，结果是否越界交给 integer_constant 判断
+		bool real = a.is_real || b.is_real;
+		switch (op) {
+		case Opcode::ADD:
+			return real ? real_constant(names, a.as_real() + b.as_real()) : integer_constant(names, a.integer + b.integer);
+		case Opcode::SUB:
+			return real ? real_constant(names, a.as_real() - b.as_real()) : integer_constant(names, a.integer - b.integer);
+		case Opcode::MUL:
+			return real ? real_constant(names, a.as_real() * b.as_real()) : integer_constant(names, a.integer * b.integer);
+		case Opcode::DIV:
+			if (real) return b.as_real() == 0 ? Operand() : real_constant(names, a.as_real() / b.as_real());
+			return b.integer == 0 ? Operand() : integer_constant(names, a.integer / b.integer);
+		case Opcode::MOD:
+			return real || b.integer == 0 ? Operand() : integer_constant(names, a.integer % b.integer);
+		case Opcode::BITAND:
+			return real ? Operand() : integer_constant(names, a.integer & b.integer);
+		case Opcode::BITOR:
+			return real ? Operand() : integer_constant(names, a.integer | b.integer);
+		case Opcode::BITXOR:
+			return real ? Operand() : integer_constant(names, a.integer ^ b.integer);
+		case Opcode::SHL:
+		case Opcode::SHR:
+			// 负数移位和移位数不小于 int 的位数在 C 中没有确定的结果，左移溢出同样不折叠
+			if (real || a.integer < 0 || b.integer < 0 || b.integer >= 32) return Operand();
+			return integer_constant(names, op == Opcode::SHL ? a.integer << b.integer : a.integer >> b.integer);
+		case Opcode::LESS:
+			return integer_constant(names, real ? a.as_real() < b.as_real() : a.integer < b.integer);
+		case Opcode::GREATER:
+			return integer_constant(names, real ? a.as_real() > b.as_real() : a.integer > b.integer);
+		case Opcode::EQUAL:
+			return integer_constant(names, real ? a.as_real() == b.as_real() : a.integer == b.integer);
+		case Opcode::NOT_EQUAL:
+			return integer_constant(names, real ? a.as_real() != b.as_real() : a.integer != b.integer);
+		case Opcode::LESS_EQUAL:
+			return integer_constant(names, real ? a.as_real() <= b.as_real() : a.integer <= b.integer);
+		case Opcode::GREATER_EQUAL:
+			return integer_constant(names, real ? a.as_real() >= b.as_real() : a.integer >= b.integer);
+		case Opcode::AND:
+			return integer_constant(names, a.truth() && b.truth());
+		case Opcode::OR:
+			return integer_constant(names, a.truth() || b.truth());
+		default:
+			return Operand();
+		}
+	}
+
+	// 操作数中是否有函数调用
+	bool has_call(const Interner& names, Operand operand)
+	{
+		if (operand.kind() != Kind::COMPOUND) return false;
+		const Compound& part = names.compound(operand.index());
+		return part.shape == Compound::Shape::CALL || has_call(names, part.first) || has_call(names, part.second);
+	}
+
+	// 扩展基本块内已知的值：变量或临时变量 -> 常量或它所复写的来源
+	// 每一项带上所属的轮次，进入新的块时轮次加一，之前的各项即全部失效，不必逐项清除
+	class Propagation {
+	public:
+		Propagation(Interner& names, size_t temp_count, std::unordered_map<uint32_t, Kind> types)
+		    : names(names), variable_slots(names.name_count()), temp_slots(temp_count), constant_temps(temp_count), types(std::move(types))
+		{
+		}
+
+		void clear() { ++epoch; }
+
+		// 把读取的位置换成已知的值；数组元素只换下标，函数调用只换实参
+		// block 为 false 时只用只定值一次的常量临时变量，它们在块之外也成立
+		Operand substitute(Operand operand, bool block = true)
+		{
+			switch (operand.kind()) {
+			case Kind::VARIABLE:
+			case Kind::TEMP: {
+				if (block) {
+					const Slot& slot = slot_of(operand);
+					if (slot.epoch == epoch) return slot.value;
+				}
+				if (operand.kind() == Kind::TEMP && !constant_temps[operand.index()].empty()) return constant_temps[operand.index()];
+				return operand;
+			}
+			case Kind::COMPOUND: {
+				Compound part = names.compound(operand.index());
+				Operand first = part.shape == Compound::Shape::LIST ? substitute(part.first, block) : part.first;
+				Operand second = substitute(part.second, block);
+				if (first == part.first && second == part.second) return operand;
+				return names.compound(part.shape, first, second);
+			}
+			default:
+				return operand;
+			}
+		}
+
+		// quater 给结果赋了新值：之前关于它的值和复写了它的项失效，再记下新值(只记录赋值)
+		void define(const Quater& quater, bool single_definition)
+		{
+			Operand target = quater.result;
+			if (target.kind() != Kind::VARIABLE && target.kind() != Kind::TEMP) return;
+			kill(target);
+			if (quater.op != Opcode::ASSIGN || quater.arg1 == target || !trackable(target, quater.arg1)) return;
+
+			Operand source = quater.arg1;
+			Slot& slot = slot_of(target);
+			slot.value = source;
+			slot.epoch = epoch;
+			if (source.is_constant()) {
+				if (target.kind() == Kind::TEMP && single_definition) constant_temps[target.index()] = source;
+				return;
+			}
+			Slot& from = slot_of(source);
+			if (from.copies_epoch != epoch) {
+				from.copies.clear();
+				from.copies_epoch = epoch;
+			}
+			from.copies.push_back(target);
+		}
+
+	private:
+		struct Slot
+		{
+			Operand value;
+			uint32_t epoch = 0;
+			std::vector<Operand> copies;  // 复写了它的变量和临时变量(可能已经失效)
+			uint32_t copies_epoch = 0;
+		};
+
+		Slot& slot_of(Operand operand) { return operand.kind() == Kind::VARIABLE ? variable_slots[operand.index()] : temp_slots[operand.index()]; }
+
+		void kill(Operand operand)
+		{
+			Slot& slot = slot_of(operand);
+			slot.epoch = 0;
+			if (slot.copies_epoch != epoch) return;
+			for (Operand copy : slot.copies) {
+				Slot& other = slot_of(copy);
+				if (other.epoch == epoch && other.value == operand) other.epoch = 0;
+			}
+			slot.copies.clear();
+		}
+
+		// 赋值 target = source 能否记录：变量要在变量表中、没有歧义，且值与它的类型相同(否则赋值时会转换)
+		// 临时变量的类型就是值的类型，但不记录复写自复合操作数的值
+		bool trackable(Operand target, Operand source) const
+		{
+			if (target.kind() == Kind::TEMP) return source.is_constant() || source.kind() == Kind::TEMP || type_of(source) != Kind::NONE;
+			Kind type = type_of(target);
+			if (type == Kind::NONE) return false;
+			return source.is_constant() ? source.kind() == type : type_of(source) == type;
+		}
+
+		Kind type_of(Operand variable) const
+		{
+			if (variable.kind() != Kind::VARIABLE) return Kind::NONE;
+			auto it = types.find(variable.index());
+			return it != types.end() ? it->second : Kind::NONE;
+		}
+
+		Interner& names;
+		std::vector<Slot> variable_slots;
+		std::vector<Slot> temp_slots;
+		std::vector<Operand> constant_temps;  // 只定值一次、值为常量的临时变量
+		std::unordered_map<uint32_t, Kind> types;  // 可以跟踪的变量 -> 类型对应的常量种类
+		uint32_t epoch = 1;
+	};
+}  // namespace
+
+std::vector<QuadCount> optimize_quads(std::vector<std::pair<size_t, Quater>>& code,
+                                      std::map<std::string, VaribleMeta>& variables,
+                                      Interner& names,
+                                      std::vector<FunctionRange>& functions)
+{
+	size_t size = code.size();
+
+	// 扩展基本块的开头：跳转目标、代码的开头、各函数的开头和结尾；以及每个临时变量的定值次数
+	std::vector<bool> block_start(size + 1, false);
+	std::vector<uint32_t> definitions;
+	block_start[0] = true;
+	for (const FunctionRange& function : functions) {
+		block_start[function.begin] = block_start[function.end] = true;
+	}
+	size_t temp_count = 0;
+	for (const auto& [id, quater] : code) {
+		if (quater.is_jump()) block_start[std::min<size_t>(quater.result.index(), size)] = true;
+		for (Operand operand : {quater.arg1, quater.arg2, quater.result}) {
+			names.for_each_temp(operand, [&](uint32_t temp) { temp_count = std::max<size_t>(temp_count, temp + 1); });
+		}
+		if (quater.result.kind() == Kind::TEMP) {
+			if (quater.result.index() >= definitions.size()) definitions.resize(quater.result.index() + 1, 0);
+			++definitions[quater.result.index()];
+		}
+	}
+	for (const auto& [name, meta] : variables) {
+		names.for_each_temp(meta.value, [&](uint32_t temp) { temp_count = std::max<size_t>(temp_count, temp + 1); });
+	}
+
+	// 可以跟踪的变量：int、float、char 类型，按名字没有歧义
+	std::unordered_map<uint32_t, Kind> types;
+	for (const auto& [name, meta] : variables) {
+		Kind kind = meta.type == "int" ? Kind::INT : meta.type == "float" ? Kind::FLOAT : meta.type == "char" ? Kind::CHAR : Kind::NONE;
+		Operand variable = names.find_variable(name);
+		if (kind != Kind::NONE && !meta.ambiguous && !variable.empty()) types.emplace(variable.index(), kind);
+	}
+
+	// 顺序扫描：替换读取的操作数，折叠常量运算和常量条件，记下赋值得到的值
+	std::vector<bool> removed(size, false);
+	Propagation values(names, temp_count, std::move(types));
+	for (size_t i = 0; i < size; ++i) {
+		if (block_start[i]) values.clear();
+		Quater& quater = code[i].second;
+		if (quater.op == Opcode::JUMP) continue;
+
+		quater.arg1 = values.substitute(quater.arg1);
+		quater.arg2 = values.substitute(quater.arg2);
+		if (quater.result.kind() == Kind::COMPOUND) quater.result = values.substitute(quater.result);
+
+		if (quater.op == Opcode::JNZ) {
+			Value condition;
+			if (!value_of(names, quater.arg1, condition)) continue;
+			if (condition.truth()) {
+				quater = Quater(Opcode::JUMP, Operand(), Operand(), quater.result);
+			} else {
+				removed[i] = true;
+			}
+			continue;
+		}
+
+		if (quater.op != Opcode::ASSIGN) {
+			Operand value = fold(names, quater.op, quater.arg1, quater.arg2);
+			if (!value.empty()) quater = Quater(Opcode::ASSIGN, value, Operand(), quater.result);
+		}
+		// 替换之后赋给自己(包括 y = x; x = y 中的第二句)，不改变任何值
+		if (quater.op == Opcode::ASSIGN && quater.arg1 == quater.result) {
+			removed[i] = true;
+			continue;
+		}
+		// 被调用的函数可能修改全局变量
+		if (has_call(names, quater.arg1) || has_call(names, quater.arg2) || has_call(names, quater.result)) values.clear();
+		bool single = quater.result.kind() == Kind::TEMP && definitions[quater.result.index()] == 1;
+		values.define(quater, single);
+	}
+
+	// 变量的初始值不在四元式中，只能换成块之外也成立的常量临时变量
+	for (auto& [name, meta] : variables) {
+		meta.value = values.substitute(meta.value, false);
+	}
+
+	// 不可达的四元式：从代码的开头、各函数的开头和结尾(其后是函数之外的代码)出发，沿顺序执行和跳转都到不了
+	std::vector<bool> reachable(size, false);
+	std::vector<size_t> pending;
+	auto reach = [&](size_t i) {
+		if (i < size && !reachable[i]) {
+			reachable[i] = true;
+			pending.push_back(i);
+		}
+	};
+	reach(0);
+	for (const FunctionRange& function : functions) {
+		reach(function.begin);
+		reach(function.end);
+	}
+	while (!pending.empty()) {
+		size_t i = pending.back();
+		pending.pop_back();
+		const Quater& quater = code[i].second;
+		if (!removed[i] && quater.is_jump()) reach(quater.result.index());
+		if (removed[i] || quater.op != Opcode::JUMP) reach(i + 1);
+	}
+	for (size_t i = 0; i < size; ++i) {
+		if (!reachable[i]) removed[i] = true;
+	}
+
+	// 结果不再被使用的临时变量：从后向前删去它们的定值，被删去的定值中用到的临时变量随之少一次使用
+	std::vector<uint32_t> uses(temp_count, 0);
+	auto count_uses = [&](Operand operand, bool add) {
+		names.for_each_temp(operand, [&](uint32_t temp) { add ? ++uses[temp] : --uses[temp]; });
+	};
+	for (size_t i = 0; i < size; ++i) {
+		if (removed[i]) continue;
+		const Quater& quater = code[i].second;
+		count_uses(quater.arg1, true);
+		count_uses(quater.arg2, true);
+		if (quater.result.kind() == Kind::COMPOUND) count_uses(quater.result, true);
+	}
+	for (const auto& [name, meta] : variables) {
+		count_uses(meta.value, true);
+	}
+	for (size_t i = size; i > 0; --i) {
+		const Quater& quater = code[i - 1].second;
+		if (removed[i - 1] || quater.result.kind() != Kind::TEMP || uses[quater.result.index()] > 0) continue;
+		if (has_call(names, quater.arg1) || has_call(names, quater.arg2)) continue;
+		removed[i - 1] = true;
+		count_uses(quater.arg1, false);
+		count_uses(quater.arg2, false);
+	}
+
+	// 跳到下一条保留的四元式的 j 没有作用：从后向前找，中间的四元式都已删去时删去它
+	size_t next_kept = size;
+	for (size_t i = size; i > 0; --i) {
+		if (removed[i - 1]) continue;
+		const Quater& quater = code[i - 1].second;
+		if (quater.op == Opcode::JUMP && quater.result.index() >= i && quater.result.index() <= next_kept) {
+			removed[i - 1] = true;
+			continue;
+		}
+		next_kept = i - 1;
+	}
+
+	// 重新编号：position[i] 为第 i 条之前保留的四元式个数，跳到被删去的四元式时改为跳到它之后第一条保留的
+	std::vector<size_t> position(size + 1, 0);
+	for (size_t i = 0; i < size; ++i) {
+		position[i + 1] = position[i] + (removed[i] ? 0 : 1);
+	}
+	std::vector<QuadCount> counts(functions.size() + 1);
+	size_t covered = 0;
+	for (size_t k = 0; k < functions.size(); ++k) {
+		FunctionRange& function = functions[k];
+		counts[k] = QuadCount{function.name, function.end - function.begin, position[function.end] - position[function.begin]};
+		covered += counts[k].before;
+		function.begin = position[function.begin];
+		function.end = position[function.end];
+	}
+	counts.back().before = size - covered;
+
+	std::vector<std::pair<size_t, Quater>> optimized;
+	optimized.reserve(position[size]);
+	for (size_t i = 0; i < size; ++i) {
+		if (removed[i]) continue;
+		Quater quater = code[i].second;
+		if (quater.is_jump()) quater.result = Operand::label(position[std::min<size_t>(quater.result.index(), size)]);
+		optimized.push_back({optimized.size(), quater});
+	}
+	code = std::move(optimized);
+
+	size_t kept = 0;
+	for (size_t k = 0; k < functions.size(); ++k) {
+		kept += counts[k].after;
+	}
+	counts.back().after = code.size() - kept;
+	if (counts.back().before == 0) counts.pop_back();
+	return counts;
+}
+
+void print_quad_counts(const std::vector<QuadCount>& counts, std::ostream& out)
+{
+	OutputBuffer buffer(out);
+
+	// 函数之外的代码记为 (global)，最后加上合计一行
+	std::vector<QuadCount> rows(counts);
+	QuadCount total{"(total)"};
+	for (QuadCount& row : rows) {
+		if (row.function.empty()) row.function = "(global)";
+		total.before += row.before;
+		total.after += row.after;
+	}
+	rows.push_back(total);
+
+	size_t maxNameLength = std::string("Function").length();
+	size_t maxBeforeLength = std::string("Before").length();
+	size_t maxAfterLength = std::string("After").length();
+	for (const auto& row : rows) {
+		maxNameLength = std::max(maxNameLength, row.function.length());
+		maxBeforeLength = std::max(maxBeforeLength, std::to_string(row.before).length());
+		maxAfterLength = std::max(maxAfterLength, std::to_string(row.after).length());
+	}
+	maxNameLength += 2;
+	maxBeforeLength += 2;
+	maxAfterLength += 2;
+
+	auto border = [&]() {
+		buffer << '+';
+		buffer.fill('-', maxNameLength);
+		buffer << '+';
+		buffer.fill('-', maxBeforeLength);
+		buffer << '+';
+		buffer.fill('-', maxAfterLength);
+		buffer << '+';
+		buffer.end_line();
+	};
+	auto line = [&](std::string_view name, std::string_view before, std::string_view after) {
+		size_t cell = buffer.position() + 1;
+		buffer << "| " << name;
+		buffer.pad(cell, maxNameLength);
+		cell = buffer.position() + 1;
+		buffer << "| " << before;
+		buffer.pad(cell, maxBeforeLength);
+		cell = buffer.position() + 1;
+		buffer << "| " << after;
+		buffer.pad(cell, maxAfterLength);
+		buffer << '|';
+		buffer.end_line();
+	};
+
+	border();
+	line("Function", "Before", "After");
+	border();
+	for (size_t i = 0; i < rows.size(); ++i) {
+		if (i + 1 == rows.size()) border();
+		line(rows[i].function, std::to_string(rows[i].before), std::to_string(rows[i].after));
+	}
+	border();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Interner.hpp"
+#include "SymbolTable.hpp"
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 一个函数优化前后的四元式条数
+struct QuadCount
+{
+	std::string function;  // 函数之外的代码(全局变量的初始值)记在名字为空的一项中
+	size_t before = 0;
+	size_t after = 0;
+};
+
+// 常量折叠与常量、复写传播：
+// 两个操作数都是整数、浮点或字符常量的算术、关系、逻辑和位运算在编译时算出，类型按 C 的规则提升：
+// 整数按 32 位的 int、浮点数按 float 计算，除以 0、结果溢出 int 和移位数不小于 32 等情况不折叠；
+// 在扩展基本块(跳转目标之间顺序执行的代码)内，把变量和临时变量换成已知的常量或它所复写的来源，函数调用之后全部失效；
+// 只定值一次的临时变量为常量时，在所有代码和变量表的初始值中都换成这个常量
+// 按名字有歧义的变量(VaribleMeta::ambiguous)和不在变量表中的形参不跟踪，变量只记录与自身类型相同的常量和变量
+// 之后条件为常量的 jnz 改为 j 或删去，再删去不可达的四元式和结果不再被使用的临时变量的定值(含函数调用的保留)
+// 删去四元式后重新编号，跳转目标和函数的范围随之修改；返回各函数优化前后的四元式条数，全局的一项在最后
+std::vector<QuadCount> optimize_quads(std::vector<std::pair<size_t, Quater>>& code,
+                                      std::map<std::string, VaribleMeta>& variables,
+                                      Interner& names,
+                                      std::vector<FunctionRange>& functions);
+
+// 输出各函数优化前后的四元式条数，最后一行为合计，格式与变量表相同
+void print_quad_counts(const std::vector<QuadCount>& counts, std::ostream& out);
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// 输出表格用的缓冲区：文本先攒在一块大的内存中，超过 capacity 时才整块写到输出流，不逐行刷新
+// 只在一行结束时才可能写出，所以一行之内可以按位置补齐、截断
+class OutputBuffer {
+public:
+	static constexpr size_t capacity = 1 << 16;
+
+	explicit OutputBuffer(std::ostream& out) : out(out), storage(capacity * 2) {}
+	~OutputBuffer() { flush(); }
+
+	OutputBuffer(const OutputBuffer&) = delete;
+	OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+	void append(const char* data, size_t size)
+	{
+		reserve(size);
+		std::memcpy(storage.data() + used, data, size);
+		used += size;
+	}
+	OutputBuffer& operator<<(std::string_view part)
+	{
+		append(part.data(), part.size());
+		return *this;
+	}
+	OutputBuffer& operator<<(char c)
+	{
+		reserve(1);
+		storage[used++] = c;
+		return *this;
+	}
+	void number(uint64_t value)
+	{
+		reserve(20);
+		used = std::to_chars(storage.data() + used, storage.data() + used + 20, value).ptr - storage.data();
+	}
+	void fill(char c, size_t count)
+	{
+		reserve(count);
+		std::memset(storage.data() + used, c, count);
+		used += count;
+	}
+
+	size_t position() const { return used; }
+	// 从 start 开始的一格不足 width 时用空格补齐，与 std::left 加 std::setw 相同
+	void pad(size_t start, size_t width)
+	{
+		if (used - start < width) fill(' ', width - (used - start));
+	}
+	// 从 start 开始的内容中有换行时，只保留第一个换行之前的部分
+	void cut_at_newline(size_t start)
+	{
+		const void* newline = std::memchr(storage.data() + start, '\n', used - start);
+		if (newline != nullptr) used = static_cast<const char*>(newline) - storage.data();
+	}
+
+	void end_line()
+	{
+		*this << '\n';
+		if (used >= capacity) flush();
+	}
+	void flush()
+	{
+		out.write(storage.data(), static_cast<std::streamsize>(used));
+		used = 0;
+	}
+
+private:
+	void reserve(size_t size)
+	{
+		if (storage.size() - used < size) storage.resize(std::max(storage.size() * 2, used + size));
+	}
+
+	std::ostream& out;
+	std::vector<char> storage;
+	size_t used = 0;
+};
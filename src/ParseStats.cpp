@@ -0,0 +1,147 @@
+#include "ParseStats.hpp"
+#include "LR1Parser.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+namespace {
+	std::mutex global_mutex;
+
+	ParseStats& global_stats()
+	{
+		static ParseStats stats;
+		return stats;
+	}
+}  // namespace
+
+ParseStats& ParseStats::instance()
+{
+	thread_local ParseStats stats;
+	return stats;
+}
+
+void ParseStats::flush()
+{
+	ParseStats& local = instance();
+	std::lock_guard<std::mutex> lock(global_mutex);
+	global_stats().merge(local);
+	local = ParseStats();
+}
+
+void ParseStats::merge(const ParseStats& other)
+{
+	for (const auto& shift : other.shifts) {
+		shifts[shift.first] += shift.second;
+	}
+	if (other.reductions.size() > reductions.size()) reductions.resize(other.reductions.size(), 0);
+	for (size_t id = 0; id < other.reductions.size(); ++id) {
+		reductions[id] += other.reductions[id];
+	}
+	if (other.state_visits.size() > state_visits.size()) state_visits.resize(other.state_visits.size(), 0);
+	for (size_t state = 0; state < other.state_visits.size(); ++state) {
+		state_visits[state] += other.state_visits[state];
+	}
+	if (other.max_stack_depth > max_stack_depth) max_stack_depth = other.max_stack_depth;
+	for (const auto& phase : other.phase_seconds) {
+		phase_seconds[phase.first] += phase.second;
+	}
+}
+
+void ParseStats::visit_state(int state, size_t depth)
+{
+	if (state >= static_cast<int>(state_visits.size())) state_visits.resize(state + 1, 0);
+	++state_visits[state];
+	if (depth > max_stack_depth) max_stack_depth = depth;
+}
+
+void ParseStats::reduce(size_t production_id)
+{
+	if (production_id >= reductions.size()) reductions.resize(production_id + 1, 0);
+	++reductions[production_id];
+}
+
+namespace {
+	std::string json_string(const std::string& text)
+	{
+		std::string result = "\"";
+		for (char c : text) {
+			if (c == '"' || c == '\\') result += '\\';
+			result += c;
+		}
+		return result + "\"";
+	}
+
+	std::string production_text(const Production& production)
+	{
+		std::string text = production.lhs.literal + " ::=";
+		for (const Symbol& symbol : production.rhs) {
+			text += " " + symbol.literal;
+		}
+		return text;
+	}
+
+	std::string dump_path;
+	std::vector<Production> dump_productions;
+
+	void dump_stats()
+	{
+		std::ofstream out(dump_path);
+		if (!out) {
+			std::cerr << "无法写入统计文件: " << dump_path << std::endl;
+			return;
+		}
+		std::lock_guard<std::mutex> lock(global_mutex);
+		global_stats().write_json(out, dump_productions);
+	}
+}  // namespace
+
+void ParseStats::write_json(std::ostream& out, const std::vector<Production>& productions) const
+{
+	out << "{\n  \"max_stack_depth\": " << max_stack_depth << ",\n";
+
+	out << "  \"phase_seconds\": {";
+	const char* separator = "\n";
+	for (const auto& phase : phase_seconds) {
+		out << separator << "    " << json_string(phase.first) << ": " << phase.second;
+		separator = ",\n";
+	}
+	out << "\n  },\n";
+
+	out << "  \"shifts\": {";
+	separator = "\n";
+	for (const auto& shift : shifts) {
+		out << separator << "    " << json_string(shift.first) << ": " << shift.second;
+		separator = ",\n";
+	}
+	out << "\n  },\n";
+
+	// 只输出出现过的产生式和状态
+	out << "  \"reductions\": [";
+	separator = "\n";
+	for (size_t id = 0; id < reductions.size(); ++id) {
+		if (reductions[id] == 0) continue;
+		std::string text = id < productions.size() ? production_text(productions[id]) : "";
+		out << separator << "    {\"id\": " << id << ", \"production\": " << json_string(text) << ", \"count\": " << reductions[id] << "}";
+		separator = ",\n";
+	}
+	out << "\n  ],\n";
+
+	out << "  \"state_visits\": {";
+	separator = "\n";
+	for (size_t state = 0; state < state_visits.size(); ++state) {
+		if (state_visits[state] == 0) continue;
+		out << separator << "    \"" << state << "\": " << state_visits[state];
+		separator = ",\n";
+	}
+	out << "\n  }\n}\n";
+}
+
+void ParseStats::dump_at_exit(const std::string& path, const std::vector<Production>& productions)
+{
+	dump_path = path;
+	dump_productions = productions;
+	// 先构造全局统计，保证它在 dump_stats 执行之后才析构
+	global_stats();
+	std::atexit(dump_stats);
+}
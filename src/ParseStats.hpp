@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+struct Production;
+
+// 语法分析统计：编译时加 -DPARSE_STATS 才会记录，否则下面的记录宏都展开为空，不影响正常版本的性能
+struct ParseStats
+{
+	std::map<std::string, size_t> shifts;          // 每个终结符的移进次数
+	std::vector<size_t> reductions;                // 每个产生式的归约次数，下标为产生式编号
+	std::vector<size_t> state_visits;              // 每个状态作为栈顶查表的次数，下标为状态编号
+	size_t max_stack_depth = 0;                    // 状态栈的最大深度
+	std::map<std::string, double> phase_seconds;   // 各阶段累计耗时(秒)，parse 包含其中读取 token 的 lex 时间
+
+	// 每个线程各自记录，flush() 时合并到全局统计中，退出时输出的是全局统计
+	static ParseStats& instance();
+	static void flush();
+
+	void visit_state(int state, size_t depth);
+	void reduce(size_t production_id);
+	void merge(const ParseStats& other);
+
+	void write_json(std::ostream& out, const std::vector<Production>& productions) const;
+	// 程序退出时把统计以 JSON 写到 path
+	static void dump_at_exit(const std::string& path, const std::vector<Production>& productions);
+};
+
+// 构造时开始计时，析构时把经过的时间累加到对应阶段
+class PhaseTimer {
+public:
+	explicit PhaseTimer(const char* phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+	~PhaseTimer()
+	{
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		ParseStats::instance().phase_seconds[phase] += elapsed.count();
+	}
+
+	PhaseTimer(const PhaseTimer&) = delete;
+	PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+	const char* phase;
+	std::chrono::steady_clock::time_point start;
+};
+
+#ifdef PARSE_STATS
+#define PARSE_STATS_CONCAT_(a, b) a##b
+#define PARSE_STATS_CONCAT(a, b) PARSE_STATS_CONCAT_(a, b)
+#define PARSE_STATS_PHASE(name) PhaseTimer PARSE_STATS_CONCAT(phase_timer_, __LINE__)(name)
+#define PARSE_STATS_STATE(state, depth) ParseStats::instance().visit_state(state, depth)
+#define PARSE_STATS_SHIFT(terminal) ++ParseStats::instance().shifts[terminal]
+#define PARSE_STATS_REDUCE(production_id) ParseStats::instance().reduce(production_id)
+#define PARSE_STATS_FLUSH() ParseStats::flush()
+#else
+#define PARSE_STATS_PHASE(name) ((void)0)
+#define PARSE_STATS_STATE(state, depth) ((void)0)
+#define PARSE_STATS_SHIFT(terminal) ((void)0)
+#define PARSE_STATS_REDUCE(production_id) ((void)0)
+#define PARSE_STATS_FLUSH() ((void)0)
+#endif
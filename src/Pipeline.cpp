@@ -0,0 +1,166 @@
+#include "Pipeline.hpp"
+#include "Lexer.hpp"
+#include "ParseStats.hpp"
+#include "SpscQueue.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace {
+	constexpr size_t token_batch_size = 256;  // 每批 token 个数
+	constexpr size_t token_queue_batches = 64;
+	constexpr size_t declaration_queue_size = 1024;
+	constexpr int spin_count = 64;  // 队列满或空时先让出这么多次时间片，仍然不行再睡眠
+
+	// 在 SpscQueue 外加上等待：短暂自旋后在条件变量上睡眠，另一端取出或放入后唤醒
+	// 只有确实有线程在睡眠时才加锁通知，队列畅通时与直接使用 SpscQueue 相同
+	template <typename T>
+	class Channel {
+	public:
+		explicit Channel(size_t capacity) : queue(capacity) {}
+
+		// 队列满时等待，cancel 之后放弃并返回 false
+		bool push(T value)
+		{
+			if (!wait_for([&]() { return queue.try_push(std::move(value)); })) return false;
+			wake();
+			return true;
+		}
+
+		void pop(T& value)
+		{
+			wait_for([&]() { return queue.try_pop(value); });
+			wake();
+		}
+
+		// 让正在等待和以后的 push 都放弃
+		void cancel()
+		{
+			cancelled.store(true, std::memory_order_relaxed);
+			std::lock_guard<std::mutex> lock(mutex);
+			ready.notify_all();
+		}
+
+	private:
+		template <typename Attempt>
+		bool wait_for(Attempt attempt)
+		{
+			for (int i = 0; i < spin_count; ++i) {
+				if (attempt()) return true;
+				if (cancelled.load(std::memory_order_relaxed)) return false;
+				std::this_thread::yield();
+			}
+
+			std::unique_lock<std::mutex> lock(mutex);
+			sleepers.fetch_add(1);
+			// 与 wake 中的栅栏配对：要么这里看到对方的修改，要么对方看到 sleepers 并通知
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			bool done = true;
+			while (!attempt()) {
+				if (cancelled.load(std::memory_order_relaxed)) {
+					done = false;
+					break;
+				}
+				ready.wait(lock);
+			}
+			sleepers.fetch_sub(1);
+			return done;
+		}
+
+		void wake()
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (sleepers.load(std::memory_order_relaxed) == 0) return;
+			std::lock_guard<std::mutex> lock(mutex);
+			ready.notify_all();
+		}
+
+		SpscQueue<T> queue;
+		std::mutex mutex;
+		std::condition_variable ready;
+		std::atomic<int> sleepers{0};
+		std::atomic<bool> cancelled{false};
+	};
+}  // namespace
+
+bool compile_pipelined(const LR1Parser& parser,
+                       const std::string& content,
+                       CompileContext& context,
+                       SemanticAnalyzer& analyzer,
+                       std::exception_ptr& semantic_error)
+{
+	Channel<std::vector<Symbol>> tokens(token_queue_batches);
+	Channel<SemanticTreeNode*> declarations(declaration_queue_size);
+
+	// 词法线程：最后一批以 T_EOF 结尾；词法错误写到调用线程设置的位置(批量编译、编译服务中为各自的输出)
+	std::ostream* lexer_errors = Lexer::get_error_output();
+	std::thread lexer_thread([&content, &tokens, lexer_errors]() {
+		Lexer::set_error_output(lexer_errors);
+		Lexer lexer(content);
+		std::vector<Symbol> batch;
+		batch.reserve(token_batch_size);
+
+		Token token;
+		do {
+			token = lexer.getNextToken();
+			batch.push_back(Symbol(SymbolType::Terminal, token.type_to_string(), token.value));
+			if (batch.size() == token_batch_size || token.type == T_EOF) {
+				if (!tokens.push(std::move(batch))) return;
+				batch.clear();
+				batch.reserve(token_batch_size);
+			}
+		} while (token.type != T_EOF);
+	});
+
+	// 语义线程：空指针表示语法分析结束
+	semantic_error = nullptr;
+	std::thread semantic_thread([&declarations, &analyzer, &semantic_error]() {
+		SemanticTreeNode* declaration = nullptr;
+		while (true) {
+			declarations.pop(declaration);
+			if (declaration == nullptr) break;
+			// 出错后只需要把队列取空
+			if (semantic_error) continue;
+			try {
+				analyzer.analyze_subtree(declaration);
+			} catch (...) {
+				semantic_error = std::current_exception();
+			}
+		}
+		PARSE_STATS_FLUSH();
+	});
+
+	// 语法分析在当前线程进行
+	std::vector<Symbol> batch;
+	size_t next = 0;
+	TokenSource next_token = [&tokens, &batch, &next]() {
+		if (next == batch.size()) {
+			// 读到 T_EOF 后语法分析器不会再要 token，这里不会越过最后一批
+			tokens.pop(batch);
+			next = 0;
+		}
+		return batch[next++];
+	};
+	SemanticAction on_reduce = [&declarations](SemanticTreeNode* node) {
+		if (node->literal == "declaration") declarations.push(node);
+	};
+
+	bool accepted = parser.parse(next_token, context.root, context.arena, on_reduce);
+
+	// 语法分析失败时词法线程可能还在等待队列空出位置
+	tokens.cancel();
+	declarations.push(nullptr);
+	lexer_thread.join();
+	semantic_thread.join();
+
+	if (!accepted || semantic_error) return accepted;
+
+	// 外层结点只是合并各个声明的结果，放在最后顺序完成
+	try {
+		analyzer.semantic_analyze();
+	} catch (...) {
+		semantic_error = std::current_exception();
+	}
+	return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "CompileContext.hpp"
+#include "LR1Parser.hpp"
+#include "SemanticAnalyzer.hpp"
+#include <exception>
+#include <string>
+
+// 流水线编译：词法分析、语法分析、语义分析各占一个线程
+// 词法线程把 token 按批放进无锁环形队列，语法线程每归约出一个顶层 declaration 就放进第二个队列，
+// 语义线程按顺序分析这些声明，语法分析结束后再补上 declaration_list、program 等外层结点
+// 分析顺序与顺序编译完全相同，所以输出(包括临时变量编号)也相同
+//
+// 返回语法分析是否成功；语法分析成功但语义分析出错时，异常保存在 semantic_error 中，
+// 由调用者在报告语法分析结果之后重新抛出，保持和顺序编译相同的输出顺序
+// analyzer 必须以 context.root 构造；词法错误写到调用线程用 Lexer::set_error_output 设置的位置
+bool compile_pipelined(const LR1Parser& parser,
+                       const std::string& content,
+                       CompileContext& context,
+                       SemanticAnalyzer& analyzer,
+                       std::exception_ptr& semantic_error);
@@ -1,25 +1,128 @@
-#pragma once
-
-#include <string>
-#include <cstring>
-
-// 四元式
-class Quater {
-public:
-	std::string op;
-	std::string arg1;
-	std::string arg2;
-	std::string result;
-
-	Quater(const std::string& op, const std::string& arg1, const std::string& arg2, const std::string& result)
-	    : op(op), arg1(arg1), arg2(arg2), result(result) {}
-
-	std::string to_string() const
-	{
-		std::string formatted_arg1 = arg1.empty() ? "_" : arg1;
-		std::string formatted_arg2 = arg2.empty() ? "_" : arg2;
-		return "(" + op + ", " + formatted_arg1 + ", " + formatted_arg2 + ", " + result + ")";
-	}
-
-	bool is_jump() const { return op[0] == 'j'; }
-};
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// 四元式的运算符
+enum class Opcode : uint8_t {
+	ASSIGN,
+	ADD,
+	SUB,
+	MUL,
+	DIV,
+	MOD,
+	BITAND,
+	BITOR,
+	BITXOR,
+	SHL,
+	SHR,
+	LESS,
+	GREATER,
+	EQUAL,
+	NOT_EQUAL,
+	LESS_EQUAL,
+	GREATER_EQUAL,
+	AND,
+	OR,
+	NOT,
+	BITNOT,
+	JNZ,   // 条件为真时跳转
+	JUMP,  // 无条件跳转
+	COUNT
+};
+
+// 运算符在输出中的写法，与源代码中的运算符相同
+inline const char* opcode_name(Opcode op)
+{
+	static const char* const names[] = {"=", "+", "-", "*", "/", "%", "&", "|", "^", "<<", ">>", "<", ">", "==", "!=", "<=", ">=", "&&", "||", "!", "~", "jnz", "j"};
+	static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(Opcode::COUNT), "运算符名字与 Opcode 不一致");
+	return names[static_cast<size_t>(op)];
+}
+
+// 由源代码中的运算符得到 Opcode，不认识的运算符返回 false
+inline bool opcode_from_string(const std::string& text, Opcode& op)
+{
+	for (size_t i = 0; i < static_cast<size_t>(Opcode::COUNT); ++i) {
+		if (text == opcode_name(static_cast<Opcode>(i))) {
+			op = static_cast<Opcode>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+// 四元式的操作数：高 4 位为种类，低 28 位为编号
+// 变量名、常量和复合操作数的编号指向 Interner 中的表，临时变量是它的序号，标号是目标四元式的编号
+class Operand {
+public:
+	enum class Kind : uint8_t {
+		NONE,      // 空(输出为 _)
+		VARIABLE,  // 变量名
+		TEMP,      // 临时变量 t<编号>
+		INT,       // 整数常量
+		FLOAT,     // 浮点常量
+		CHAR,      // 字符常量
+		STRING,    // 字符串常量
+		LABEL,     // 跳转目标
+		COMPOUND   // 还不翻译的函数调用、数组元素，由 Interner 中的两个操作数组成
+	};
+
+	static constexpr uint32_t max_index = (1u << 28) - 1;
+
+	Operand() = default;
+	Operand(Kind kind, size_t index) : bits(static_cast<uint32_t>(kind) << 28 | checked_index(index)) {}
+
+	static Operand temp(size_t id) { return Operand(Kind::TEMP, id); }
+	static Operand label(size_t target) { return Operand(Kind::LABEL, target); }
+
+	// 编号放不进 28 位时报错，不截断成另一个操作数
+	static uint32_t checked_index(size_t index)
+	{
+		if (index > max_index) throw std::length_error("Operand index exceeds 28 bits: " + std::to_string(index));
+		return static_cast<uint32_t>(index);
+	}
+
+	Kind kind() const { return static_cast<Kind>(bits >> 28); }
+	uint32_t index() const { return bits & max_index; }
+	bool empty() const { return bits == 0; }
+	bool is_constant() const { return kind() >= Kind::INT && kind() <= Kind::STRING; }
+
+	uint32_t raw() const { return bits; }
+	static Operand from_raw(uint32_t bits)
+	{
+		Operand operand;
+		operand.bits = bits;
+		return operand;
+	}
+
+	bool operator==(const Operand& other) const { return bits == other.bits; }
+	bool operator!=(const Operand& other) const { return bits != other.bits; }
+
+private:
+	uint32_t bits = 0;
+};
+
+// 四元式：运算符和三个操作数，共 16 字节，名字和常量的文本只在输出时才从 Interner 中取出
+class Quater {
+public:
+	Opcode op;
+	Operand arg1;
+	Operand arg2;
+	Operand result;
+
+	Quater(Opcode op, Operand arg1, Operand arg2, Operand result)
+	    : op(op), arg1(arg1), arg2(arg2), result(result) {}
+
+	bool is_jump() const { return op == Opcode::JNZ || op == Opcode::JUMP; }
+};
+
+static_assert(sizeof(Quater) == 16, "四元式应为 16 字节");
+
+// 一个函数的代码在中间代码中的范围 [begin, end)
+struct FunctionRange
+{
+	std::string name;
+	size_t begin;
+	size_t end;
+};
@@ -1,487 +1,1137 @@
-#include "SemanticAnalyzer.hpp"
-
-void SemanticAnalyzer::print_intermediate_code()
-{
-	// 首先检查中间代码是否为空
-	if (intermediate_code().empty()) {
-		std::cout << "Intermediate code table is empty." << std::endl;
-		return;
-	}
-
-	// 确定ID列的最大宽度
-	size_t maxIdLength = std::string("ID").length();
-	for (const auto& [id, _] : intermediate_code()) {
-		maxIdLength = std::max(maxIdLength, std::to_string(id).length());
-	}
-	maxIdLength += 2;  // 增加一些额外的空间以美化输出
-
-	// 四元式每部分的最大宽度
-	size_t maxPart1Length = 0, maxPart2Length = 0, maxPart3Length = 0, maxPart4Length = 0;
-	for (const auto& [_, item] : intermediate_code()) {
-		std::istringstream iss(item.to_string());
-		std::string part;
-		std::getline(iss, part, ',');  // 第一部分
-		maxPart1Length = std::max(maxPart1Length, part.length());
-		std::getline(iss, part, ',');  // 第二部分
-		maxPart2Length = std::max(maxPart2Length, part.length());
-		std::getline(iss, part, ',');  // 第三部分
-		maxPart3Length = std::max(maxPart3Length, part.length());
-		std::getline(iss, part, ')');  // 第四部分
-		maxPart4Length = std::max(maxPart4Length, part.length());
-	}
-
-	maxPart1Length += 1;
-	maxPart2Length += 1;
-	maxPart3Length += 1;
-	maxPart4Length += 0;
-	// 计算四元式列的总宽度
-	size_t maxItemLength = maxPart1Length + maxPart2Length + maxPart3Length + maxPart4Length + 6;  // 9 是四个逗号和两个括号的长度
-
-	// 计算总长度和打印表头
-	size_t totalLength = maxIdLength + maxItemLength + 5;  // 5 是分隔符和边界的长度
-	std::string topBottomBorder = "+" + std::string(maxIdLength, '-') + "+" + std::string(maxItemLength, '-') + "+";
-	std::cout << topBottomBorder << std::endl;
-	std::cout << std::left << "|" << std::setw(maxIdLength) << " ID "
-	          << "|" << std::setw(maxItemLength) << " Quarter "
-	          << "|" << std::endl;
-	std::cout << topBottomBorder << std::endl;
-
-	// 遍历中间代码并打印
-	for (const auto& [id, item] : intermediate_code()) {
-		std::istringstream iss(item.to_string());
-		std::string part1, part2, part3, part4;
-		std::getline(iss, part1, ',');
-		std::getline(iss, part2, ',');
-		std::getline(iss, part3, ',');
-		std::getline(iss, part4, ')');
-		std::string item_;
-		std::stringstream ss;
-		ss << " " << std::left << std::setw(maxPart1Length) << part1
-		   << "," << std::setw(maxPart2Length) << part2
-		   << "," << std::setw(maxPart3Length) << part3
-		   << "," << std::setw(maxPart4Length) << part4 << ")";
-		std::getline(ss, item_);
-
-		std::cout << std::left << "|" << std::setw(maxIdLength) << (" " + std::to_string(id))
-		          << "|"
-		          << std::setw(maxItemLength) << item_
-		          << "|" << std::endl;
-	}
-
-	// 打印底部横线
-	std::cout << topBottomBorder << std::endl;
-}
-
-
-void SemanticAnalyzer::print_variable_table()
-{
-	// 检查变量表是否为空
-	if (varible_table.empty()) {
-		std::cout << "Variable table is empty." << std::endl;
-		return;
-	}
-
-	// 确定每列的最大宽度
-	size_t maxNameLength = std::string("Variable Name").length();
-	size_t maxTypeLength = std::string("Type").length();
-	size_t maxValueLength = std::string("Initial Value").length();
-
-	for (const auto& pair : varible_table) {
-		maxNameLength = std::max(maxNameLength, pair.first.length());
-		maxTypeLength = std::max(maxTypeLength, pair.second.type.length());
-		maxValueLength = std::max(maxValueLength, pair.second.value.length());
-	}
-
-	// 增加一些额外的空间以美化输出
-	maxNameLength += 2;
-	maxTypeLength += 2;
-	maxValueLength += 2;
-
-	// 计算总长度和打印表头
-	size_t totalLength = maxNameLength + maxTypeLength + maxValueLength + 7;  // 7 是分隔符和边界的长度
-	std::string topBottomBorder = "+" + std::string(maxNameLength, '-') + "+" + std::string(maxTypeLength, '-') + "+" + std::string(maxValueLength, '-') + "+";
-	std::cout << topBottomBorder << std::endl;
-	std::cout << std::left << "|" << std::setw(maxNameLength) << " Variable Name "
-	          << "|" << std::setw(maxTypeLength) << " Type "
-	          << "|" << std::setw(maxValueLength) << " Initial Value "
-	          << "|" << std::endl;
-	std::cout << topBottomBorder << std::endl;
-
-	// 遍历varible_table并打印
-	for (const auto& pair : varible_table) {
-		std::cout << std::left << "|" << std::setw(maxNameLength) << (" " + pair.first)
-		          << "|" << std::setw(maxTypeLength) << (" " + pair.second.type)
-		          << "|" << std::setw(maxValueLength) << (" " + pair.second.value) << "|" << std::endl;
-	}
-
-	// 打印底部横线
-	std::cout << topBottomBorder << std::endl;
-}
-
-void SemanticAnalyzer::semantic_analyze()
-{
-	if (root == nullptr) return;
-
-	std::stack<SemanticTreeNode*> stack1, stack2;
-	stack1.push(root);
-
-	while (!stack1.empty()) {
-		SemanticTreeNode* node = stack1.top();
-		stack1.pop();
-		stack2.push(node);
-
-		for (SemanticTreeNode* child : node->children) {
-			stack1.push(child);
-		}
-	}
-
-	while (!stack2.empty()) {
-		SemanticTreeNode* node = stack2.top();
-		stack2.pop();
-
-		// Process node - this can be customized as needed
-		// For example, print node information
-		if (node->leaf()) {
-			continue;
-		}
-
-		handle_defalt(node);
-
-		if (node->literal == "var_declaration") {
-			handle_var_declaration(node);
-		} else if (node->literal == "opt_init") {
-			handle_opt_init(node);
-		} else if (node->literal == "expression") {
-			handle_expression(node);
-		} else if (node->literal == "simple_expression") {
-			handle_simple_expression(node);
-		} else if (node->literal == "additive_expression") {
-			handle_additive_expression(node);
-		} else if (node->literal == "term") {
-			handle_term(node);
-		} else if (node->literal == "postfix_expression") {
-			handle_postfix_expression(node);
-		} else if (node->literal == "factor") {
-			handle_factor(node);
-		} else if (node->literal == "prefix_expression") {
-			handle_prefix_expression(node);
-		} else if (node->literal == "selection_stmt") {
-			handle_selection_stmt(node);
-		} else if (node->literal == "iteration_stmt") {
-			handle_iteration_stmt(node);
-		} else if (node->literal == "opt_expression_stmt") {
-			handle_opt_expression_stmt(node);
-		}
-
-		if (node->children.size() == 1 && node->children[0]->literal == "T_IDENTIFIER") {
-			node->literal = node->children[0]->literal;
-		}
-	}
-}
-
-void SemanticAnalyzer::handle_defalt(SemanticTreeNode*& node)
-{
-	for (const auto& child : node->children) {
-		node->real_value += child->real_value;
-		if (node->literal != "selection_stmt" && node->literal != "iteration_stmt") {
-			node->append_quaters(child->quater_list);
-		}
-	}
-}
-
-void SemanticAnalyzer::handle_var_declaration(SemanticTreeNode*& node)
-{
-	// type_specifier T_IDENTIFIER opt_init T_SEMICOLON
-	// type_specifier T_IDENTIFIER T_SEMICOLON
-	const auto& list = node->children;
-
-	const std::string& type = list[0]->real_value;
-	const std::string& varible_name = list[1]->real_value;
-	const std::string& init_val = list[2]->literal == "opt_init" ? list[2]->real_value : "NULL";
-
-	if (varible_table.find(varible_name) != varible_table.end()) {
-		// 如果变量表中已经有了这个变量，报错
-		std::cout << "Error：重定义变量：" << varible_name << std::endl;
-		exit(-1);
-	}
-
-	varible_table[varible_name] = {type, init_val};
-	node->real_value = type + " " + varible_name + " " + init_val + ";";
-}
-
-void SemanticAnalyzer::handle_opt_init(SemanticTreeNode*& node)
-{
-	// T_ASSIGN expression
-	const auto& list = node->children;
-
-	node->real_value = list[1]->real_value;
-}
-
-void SemanticAnalyzer::handle_expression(SemanticTreeNode*& node)
-{
-	/*
-	simple_expression
-	postfix_expression
-
-	var T_ASSIGN expression
-	a = exp
-	(=, t, _, a)
-	*/
-	const auto& list = node->children;
-
-	if (list.size() == 1) {
-		return;
-	}
-
-	const std::string& var = list[0]->real_value;
-	const std::string& op = list[1]->real_value;
-	const std::string& exp = list[2]->real_value;
-	if (list[0]->literal == "T_IDENTIFIER" && !exists_var_declaration(var)) {
-		std::cout << "Error: 未定义变量：" << var << std::endl;
-		exit(-1);
-	}
-	if (list[2]->literal == "T_IDENTIFIER" && !exists_var_declaration(exp)) {
-		std::cout << "Error: 未定义变量：" << exp << std::endl;
-		exit(-1);
-	}
-	node->add_quater(op, exp, "", var);
-	node->real_value = var;
-}
-
-void SemanticAnalyzer::handle_simple_expression(SemanticTreeNode*& node)
-{
-	/*
-	additive_expression relop additive_expression
-	simple_expression relop simple_expression
-	additive_expression
-	*/
-	const auto& list = node->children;
-
-	if (list.size() == 1) {
-		return;
-	}
-
-	const std::string& arg1 = list[0]->real_value;
-	const std::string& op = list[1]->real_value;
-	const std::string& arg2 = list[2]->real_value;
-
-	std::string new_temp = new_temp_varible();
-	node->add_quater(op, arg1, arg2, new_temp);
-	node->real_value = new_temp;
-}
-
-void SemanticAnalyzer::handle_additive_expression(SemanticTreeNode*& node)
-{
-	/*
-	term
-	additive_expression addop term
-	*/
-
-	const auto& list = node->children;
-
-	if (list.size() == 1) {
-		return;
-	}
-
-	const std::string& arg1 = list[0]->real_value;
-	const std::string& op = list[1]->real_value;
-	const std::string& arg2 = list[2]->real_value;
-
-	std::string new_temp = new_temp_varible();
-	node->add_quater(op, arg1, arg2, new_temp);
-	node->real_value = new_temp;
-}
-
-void SemanticAnalyzer::handle_term(SemanticTreeNode*& node)
-{
-	/*
-	factor
-	postfix_expression
-	term mulop factor
-	*/
-	const auto& list = node->children;
-
-	if (list.size() == 1) {
-		return;
-	}
-
-	const std::string& arg1 = list[0]->real_value;
-	const std::string& op = list[1]->real_value;
-	const std::string& arg2 = list[2]->real_value;
-
-	std::string new_temp = new_temp_varible();
-	node->add_quater(op, arg1, arg2, new_temp);
-	node->real_value = new_temp;
-}
-
-void SemanticAnalyzer::handle_factor(SemanticTreeNode*& node)
-{
-	/*
-	T_LEFT_PAREN expression T_RIGHT_PAREN
-	var
-	T_INTEGER_LITERAL
-	T_STRING_LITERAL
-	T_CHAR_LITERAL
-	T_FLOAT_LITERAL
-	prefix_expression
-
-	call 		*本次作业不处理函数调用
-	*/
-	const auto& list = node->children;
-
-	if (list.size() == 1) {
-		return;
-	}
-
-	node->real_value = list[1]->real_value;
-}
-
-void SemanticAnalyzer::handle_prefix_expression(SemanticTreeNode*& node)
-{
-	/*
-	inc_dec_operator var   ++a
-	(++, a, _, a)
-
-	T_NOT factor
-	T_BITNOT factor
-	(~/!, a, _, t1)
-	*/
-	const auto& list = node->children;
-
-	const std::string& op = list[0]->real_value;
-	const std::string& varible_name = list[1]->real_value;
-
-	if (list[0]->literal == "inc_dec_operator") {
-		std::string op_ = op == "++" ? "+" : "-";
-		node->add_quater(op_, varible_name, "1", varible_name);
-		node->real_value = varible_name;
-	} else {
-		std::string new_temp = new_temp_varible();
-		node->add_quater(op, varible_name, "", new_temp);
-		node->real_value = new_temp;
-	}
-}
-
-void SemanticAnalyzer::handle_postfix_expression(SemanticTreeNode*& node)
-{
-	/*
-	var inc_dec_operator   			a++, b--
-
-	(=, a, _, t1)
-	(++, a, _, a)
-	*/
-	const auto& list = node->children;
-
-	const std::string& varible_name = list[0]->real_value;
-	const std::string& op = list[1]->real_value;
-
-	std::string new_temp = new_temp_varible();
-	node->add_quater("=", varible_name, "", new_temp);
-	std::string op_ = op == "++" ? "+" : "-";
-	node->add_quater(op_, varible_name, "1", varible_name);
-
-	node->real_value = new_temp;
-}
-
-void SemanticAnalyzer::handle_var(SemanticTreeNode*& node)
-{
-	/*
-	T_IDENTIFIER
-	T_IDENTIFIER T_LEFT_SQUARE expression T_RIGHT_SQUARE a[]
-	*/
-
-	// 暂时不考虑数组
-	return;
-}
-
-void SemanticAnalyzer::handle_selection_stmt(SemanticTreeNode*& node)
-{
-	/*
-	T_IF T_LEFT_PAREN expression T_RIGHT_PAREN statement
-	T_IF T_LEFT_PAREN expression T_RIGHT_PAREN statement T_ELSE statement
-	*/
-
-	const auto& list = node->children;
-
-	const auto& stmt_THEN = list[4];
-	const auto& cond = list[2]->real_value;
-	node->append_quaters(list[2]->quater_list);
-
-	size_t THEN = -1;
-	size_t ELSE = -1;
-	size_t ENDIF = -1;
-
-
-	if (list.size() == 5) {
-		THEN = 2 + list[2]->quater_list.size();
-		ENDIF = THEN + stmt_THEN->quater_list.size();
-
-		node->add_quater("jnz", cond, "", THEN);
-		node->add_quater("j", "", "", ENDIF);
-		node->append_quaters(stmt_THEN->quater_list);
-	} else if (list.size() == 7) {
-		const auto& stmt_ELSE = list[6];
-		ELSE = 1 + list[2]->quater_list.size();
-		THEN = ELSE + stmt_ELSE->children.size() + 1;
-		ENDIF = THEN + stmt_THEN->children.size();
-
-		node->add_quater("jnz", cond, "", THEN);
-		node->append_quaters(stmt_ELSE->quater_list);
-		node->add_quater("j", "", "", ENDIF);
-		node->append_quaters(stmt_THEN->quater_list);
-	}
-}
-
-void SemanticAnalyzer::handle_iteration_stmt(SemanticTreeNode*& node)
-{
-	const auto& list = node->children;
-
-
-	if (list[0]->literal == "T_WHILE") {
-		/*
-		T_WHILE T_LEFT_PAREN expression T_RIGHT_PAREN statement
-		*/
-		const auto& cond = list[2]->real_value;
-		const auto& stmt = list[4];
-		size_t LOOP = 0;
-		size_t BODY = LOOP + list[2]->quater_list.size() + 2;
-		size_t END_LOOP = BODY + stmt->quater_list.size() + 1;
-
-		node->append_quaters(list[2]->quater_list);
-		node->add_quater("jnz", cond, "", BODY);
-		node->add_quater("j", "", "", END_LOOP);
-		node->append_quaters(stmt->quater_list);
-		node->add_quater("j", "", "", LOOP);
-	} else if (list[0]->literal == "T_FOR") {
-		/*
-		T_FOR T_LEFT_PAREN opt_expression_stmt opt_expression_stmt expression T_RIGHT_PAREN statement
-		*/
-		const auto& exp1 = list[2];
-		const auto& exp2 = list[3];
-		const auto& exp3 = list[4];
-		const auto& stmt = list[6];
-
-		size_t START = exp1->quater_list.size();
-		size_t BODY = START + exp2->quater_list.size() + 2;
-		size_t END_LOOP = BODY + stmt->quater_list.size() + exp3->quater_list.size() + 1;
-
-		node->append_quaters(exp1->quater_list);
-		node->append_quaters(exp2->quater_list);
-		node->add_quater("jnz", exp2->real_value, "", BODY);
-		node->add_quater("j", "", "", END_LOOP);
-		node->append_quaters(stmt->quater_list);
-		node->append_quaters(exp3->quater_list);
-		node->add_quater("j", "", "", START);
-	}
-}
-
-void SemanticAnalyzer::handle_opt_expression_stmt(SemanticTreeNode*& node)
-{
-	/*
-	expression_stmt
-	T_SEMICOLON
-	*/
-	node->real_value = node->real_value.substr(0, node->real_value.size() - 1);  // 去掉分号;
-
-	return;
-}
\ No newline at end of file
+#include "SemanticAnalyzer.hpp"
+#include "OutputBuffer.hpp"
+#include "ThreadPool.hpp"
+#include <memory>
+#include <string_view>
+
+namespace {
+	// 把四元式的文本按前三个逗号和其后的第一个 ')' 分成四部分，例如 "(+, a, 1, t0)" 分成 "(+"、" a"、" 1"、" t0"
+	// 操作数本身可能带逗号(实参列表、字符串常量)，这时按最先出现的逗号切分，与最初按 getline 切分的表格保持一致
+	struct QuadParts
+	{
+		std::string_view part[4];
+	};
+
+	QuadParts split_quad_text(std::string_view text)
+	{
+		QuadParts parts;
+		for (int i = 0; i < 4; ++i) {
+			size_t cut = text.find(i < 3 ? ',' : ')');
+			parts.part[i] = text.substr(0, cut);
+			text = cut == std::string_view::npos ? std::string_view() : text.substr(cut + 1);
+		}
+		return parts;
+	}
+
+	// 四元式的文本能否直接按操作数分成四部分：前两个操作数中没有逗号，结果中没有 ')'，各部分都没有换行
+	bool plain_quad(const Quater& quater, const Interner& names)
+	{
+		uint8_t args = names.text_marks(quater.arg1) | names.text_marks(quater.arg2);
+		uint8_t result = names.text_marks(quater.result);
+		return (args & (Interner::MARK_COMMA | Interner::MARK_NEWLINE)) == 0 && (result & (Interner::MARK_RIGHT_PAREN | Interner::MARK_NEWLINE)) == 0;
+	}
+
+	// 边归约边翻译时的语义动作：出现语义错误后记下它，之后的动作都不再执行，语法分析照常进行到结束
+	SemanticAction until_error(SemanticAction action, std::exception_ptr& error)
+	{
+		return [action = std::move(action), &error](SemanticTreeNode* node) {
+			if (error) return;
+			try {
+				action(node);
+			} catch (const SemanticError&) {
+				error = std::current_exception();
+			}
+		};
+	}
+}  // namespace
+
+void SemanticAnalyzer::print_intermediate_code(const std::vector<std::pair<size_t, Quater>>& code, const Interner& names, std::ostream& out)
+{
+	OutputBuffer buffer(out);
+	// 首先检查中间代码是否为空
+	if (code.empty()) {
+		buffer << "Intermediate code table is empty.";
+		buffer.end_line();
+		return;
+	}
+
+	// 四元式每部分的长度："(运算符"、" 操作数1"、" 操作数2"、" 结果"，一般直接由操作数文本的长度得到；
+	// 少数操作数中带逗号、')' 或换行的四元式，先生成文本再切分
+	std::string scratch;
+	auto part_lengths = [&](const Quater& item, size_t length[4]) {
+		if (plain_quad(item, names)) {
+			length[0] = 1 + std::char_traits<char>::length(opcode_name(item.op));
+			length[1] = 1 + (item.arg1.empty() ? 1 : names.text_length(item.arg1));
+			length[2] = 1 + (item.arg2.empty() ? 1 : names.text_length(item.arg2));
+			length[3] = 1 + names.text_length(item.result);
+			return;
+		}
+		scratch.clear();
+		names.append_text(scratch, item);
+		QuadParts parts = split_quad_text(scratch);
+		for (int i = 0; i < 4; ++i) length[i] = parts.part[i].length();
+	};
+
+	// 确定ID列和四元式每部分的最大宽度
+	size_t maxId = 0;
+	size_t maxPart1Length = 0, maxPart2Length = 0, maxPart3Length = 0, maxPart4Length = 0;
+	for (const auto& [id, item] : code) {
+		size_t length[4];
+		part_lengths(item, length);
+		maxId = std::max(maxId, id);
+		maxPart1Length = std::max(maxPart1Length, length[0]);
+		maxPart2Length = std::max(maxPart2Length, length[1]);
+		maxPart3Length = std::max(maxPart3Length, length[2]);
+		maxPart4Length = std::max(maxPart4Length, length[3]);
+	}
+
+	size_t maxIdLength = std::max(std::string("ID").length(), std::to_string(maxId).length());
+	maxIdLength += 2;  // 增加一些额外的空间以美化输出
+
+	maxPart1Length += 1;
+	maxPart2Length += 1;
+	maxPart3Length += 1;
+	maxPart4Length += 0;
+	// 计算四元式列的总宽度
+	size_t maxItemLength = maxPart1Length + maxPart2Length + maxPart3Length + maxPart4Length + 6;  // 9 是四个逗号和两个括号的长度
+
+	// 打印表头
+	auto border = [&]() {
+		buffer << '+';
+		buffer.fill('-', maxIdLength);
+		buffer << '+';
+		buffer.fill('-', maxItemLength);
+		buffer << '+';
+		buffer.end_line();
+	};
+	border();
+	size_t cell = buffer.position() + 1;
+	buffer << "| ID ";
+	buffer.pad(cell, maxIdLength);
+	cell = buffer.position() + 1;
+	buffer << "| Quarter ";
+	buffer.pad(cell, maxItemLength);
+	buffer << '|';
+	buffer.end_line();
+	border();
+
+	// 遍历中间代码并打印，每部分左对齐后以逗号分隔
+	size_t widths[4] = {maxPart1Length, maxPart2Length, maxPart3Length, maxPart4Length};
+	for (const auto& [id, item] : code) {
+		cell = buffer.position() + 1;
+		buffer << "| ";
+		buffer.number(id);
+		buffer.pad(cell, maxIdLength);
+		buffer << '|';
+
+		cell = buffer.position();
+		buffer << ' ';
+		if (plain_quad(item, names)) {
+			Operand operands[3] = {item.arg1, item.arg2, item.result};
+			size_t part = buffer.position();
+			buffer << '(' << opcode_name(item.op);
+			for (int i = 0; i < 3; ++i) {
+				buffer.pad(part, widths[i]);
+				buffer << ',';
+				part = buffer.position();
+				buffer << ' ';
+				if (i < 2 && operands[i].empty()) buffer << '_';
+				names.append_text(buffer, operands[i]);
+			}
+			buffer.pad(part, widths[3]);
+			buffer << ')';
+		} else {
+			scratch.clear();
+			names.append_text(scratch, item);
+			QuadParts parts = split_quad_text(scratch);
+			for (int i = 0; i < 4; ++i) {
+				size_t part = buffer.position();
+				buffer << parts.part[i];
+				buffer.pad(part, widths[i]);
+				buffer << (i < 3 ? ',' : ')');
+			}
+			buffer.cut_at_newline(cell);
+		}
+		buffer.pad(cell, maxItemLength);
+		buffer << '|';
+		buffer.end_line();
+	}
+
+	// 打印底部横线
+	border();
+}
+
+
+void SemanticAnalyzer::print_variable_table(const std::map<std::string, VaribleMeta>& table, const Interner& names, std::ostream& out)
+{
+	OutputBuffer buffer(out);
+	// 检查变量表是否为空
+	if (table.empty()) {
+		buffer << "Variable table is empty.";
+		buffer.end_line();
+		return;
+	}
+
+	// 确定每列的最大宽度
+	size_t maxNameLength = std::string("Variable Name").length();
+	size_t maxTypeLength = std::string("Type").length();
+	size_t maxValueLength = std::string("Initial Value").length();
+
+	// 没有初始值的变量输出 NULL
+	for (const auto& pair : table) {
+		maxNameLength = std::max(maxNameLength, pair.first.length());
+		maxTypeLength = std::max(maxTypeLength, pair.second.type.length());
+		maxValueLength = std::max(maxValueLength, pair.second.value.empty() ? std::string("NULL").length() : names.text_length(pair.second.value));
+	}
+
+	// 增加一些额外的空间以美化输出
+	maxNameLength += 2;
+	maxTypeLength += 2;
+	maxValueLength += 2;
+
+	// 打印表头
+	auto border = [&]() {
+		buffer << '+';
+		buffer.fill('-', maxNameLength);
+		buffer << '+';
+		buffer.fill('-', maxTypeLength);
+		buffer << '+';
+		buffer.fill('-', maxValueLength);
+		buffer << '+';
+		buffer.end_line();
+	};
+	auto cell = [&](std::string_view text, size_t width) {
+		size_t start = buffer.position() + 1;
+		buffer << "| " << text;
+		buffer.pad(start, width);
+	};
+	border();
+	cell("Variable Name ", maxNameLength);
+	cell("Type ", maxTypeLength);
+	cell("Initial Value ", maxValueLength);
+	buffer << '|';
+	buffer.end_line();
+	border();
+
+	// 遍历table并打印
+	for (const auto& pair : table) {
+		cell(pair.first, maxNameLength);
+		cell(pair.second.type, maxTypeLength);
+		size_t start = buffer.position() + 1;
+		buffer << "| ";
+		if (pair.second.value.empty()) {
+			buffer << "NULL";
+		} else {
+			names.append_text(buffer, pair.second.value);
+		}
+		buffer.pad(start, maxValueLength);
+		buffer << '|';
+		buffer.end_line();
+	}
+
+	// 打印底部横线
+	border();
+}
+
+SemanticAnalyzer::SemanticAnalyzer(SemanticTreeNode*& root, const std::vector<Production>& productions)
+    : root(root), productions(productions), handlers(productions.size(), &SemanticAnalyzer::handle_defalt), next_temp_varible_id(0)
+{
+	for (const auto& [rule, handler] : builtin_handlers()) {
+		register_handler(rule, handler);
+	}
+}
+
+const std::vector<std::pair<const char*, SemanticAnalyzer::Handler>>& SemanticAnalyzer::builtin_handlers()
+{
+	static const std::vector<std::pair<const char*, Handler>> rules = {
+	    {"var_declaration ::= type_specifier T_IDENTIFIER opt_init T_SEMICOLON", &SemanticAnalyzer::handle_initialized_declaration},
+	    {"var_declaration ::= type_specifier T_IDENTIFIER T_SEMICOLON", &SemanticAnalyzer::handle_var_declaration},
+	    {"var_declaration ::= type_specifier T_IDENTIFIER T_LEFT_SQUARE T_INTEGER_LITERAL T_RIGHT_SQUARE T_SEMICOLON", &SemanticAnalyzer::handle_var_declaration},
+	    {"opt_init ::= T_ASSIGN expression", &SemanticAnalyzer::handle_opt_init},
+	    {"expression ::= var T_ASSIGN expression", &SemanticAnalyzer::handle_assignment},
+	    {"var ::= T_IDENTIFIER T_LEFT_SQUARE expression T_RIGHT_SQUARE", &SemanticAnalyzer::handle_array_element},
+	    {"simple_expression ::= additive_expression relop additive_expression", &SemanticAnalyzer::handle_binary_expression},
+	    {"simple_expression ::= simple_expression relop simple_expression", &SemanticAnalyzer::handle_binary_expression},
+	    {"additive_expression ::= additive_expression addop term", &SemanticAnalyzer::handle_binary_expression},
+	    {"term ::= term mulop factor", &SemanticAnalyzer::handle_binary_expression},
+	    {"factor ::= T_LEFT_PAREN expression T_RIGHT_PAREN", &SemanticAnalyzer::handle_factor},
+	    {"call ::= T_IDENTIFIER T_LEFT_PAREN args T_RIGHT_PAREN", &SemanticAnalyzer::handle_call},
+	    {"call ::= T_IDENTIFIER T_LEFT_PAREN T_RIGHT_PAREN", &SemanticAnalyzer::handle_call_without_args},
+	    {"arg_list ::= arg_list T_COMMA expression", &SemanticAnalyzer::handle_arg_list},
+	    {"postfix_expression ::= var inc_dec_operator", &SemanticAnalyzer::handle_postfix_expression},
+	    {"prefix_expression ::= inc_dec_operator var", &SemanticAnalyzer::handle_prefix_increment},
+	    {"prefix_expression ::= T_NOT factor", &SemanticAnalyzer::handle_prefix_expression},
+	    {"prefix_expression ::= T_BITNOT factor", &SemanticAnalyzer::handle_prefix_expression},
+	    {"selection_stmt ::= T_IF T_LEFT_PAREN expression T_RIGHT_PAREN statement", &SemanticAnalyzer::handle_if},
+	    {"selection_stmt ::= T_IF T_LEFT_PAREN expression T_RIGHT_PAREN statement T_ELSE statement", &SemanticAnalyzer::handle_if_else},
+	    {"iteration_stmt ::= T_WHILE T_LEFT_PAREN expression T_RIGHT_PAREN statement", &SemanticAnalyzer::handle_while},
+	    {"iteration_stmt ::= T_FOR T_LEFT_PAREN opt_expression_stmt opt_expression_stmt expression T_RIGHT_PAREN statement", &SemanticAnalyzer::handle_for},
+	    {"compound_stmt ::= T_LEFT_BRACE block_items T_RIGHT_BRACE", &SemanticAnalyzer::handle_compound_stmt},
+	    {"compound_stmt ::= T_LEFT_BRACE T_RIGHT_BRACE", &SemanticAnalyzer::handle_compound_stmt},
+	    {"param ::= type_specifier T_IDENTIFIER", &SemanticAnalyzer::handle_param},
+	    {"declaration ::= var_declaration", &SemanticAnalyzer::handle_global_declaration},
+	    {"fun_declaration ::= type_specifier T_IDENTIFIER T_LEFT_PAREN params T_RIGHT_PAREN compound_stmt", &SemanticAnalyzer::handle_fun_declaration},
+	    {"fun_declaration ::= type_specifier T_IDENTIFIER T_LEFT_PAREN T_RIGHT_PAREN compound_stmt", &SemanticAnalyzer::handle_fun_declaration},
+	    {"param ::= type_specifier T_IDENTIFIER T_LEFT_SQUARE T_RIGHT_SQUARE", &SemanticAnalyzer::handle_param},
+	};
+	return rules;
+}
+
+bool SemanticAnalyzer::register_handler(const std::string& rule, Handler handler)
+{
+	std::istringstream in(rule);
+	std::string lhs, arrow, symbol;
+	std::vector<std::string> rhs;
+	in >> lhs >> arrow;
+	while (in >> symbol) {
+		rhs.push_back(symbol);
+	}
+	if (arrow != "::=") return false;
+
+	// 文法中可能有重复的候选式，全部注册
+	bool found = false;
+	for (size_t i = 0; i < productions.size(); ++i) {
+		const Production& production = productions[i];
+		if (production.lhs.literal != lhs || production.rhs.size() != rhs.size()) continue;
+		if (!std::equal(rhs.begin(), rhs.end(), production.rhs.begin(), [](const std::string& a, const Symbol& b) { return a == b.literal; })) continue;
+		handlers[i] = handler;
+		found = true;
+	}
+	return found;
+}
+
+void SemanticAnalyzer::semantic_analyze()
+{
+	analyze_subtree(root);
+}
+
+void SemanticAnalyzer::analyze_subtree(SemanticTreeNode* subtree)
+{
+	if (subtree == nullptr) return;
+
+	std::stack<SemanticTreeNode*> stack1, stack2;
+	stack1.push(subtree);
+
+	while (!stack1.empty()) {
+		SemanticTreeNode* node = stack1.top();
+		stack1.pop();
+		// 已经分析过的子树(增量分析复用的部分)不再展开，只有形参要在函数体中重新登记
+		if (node->analyzed) {
+			if (node->literal == "params" || node->literal == "param_list" || node->literal == "param") stack2.push(node);
+			continue;
+		}
+		stack2.push(node);
+
+		for (SemanticTreeNode* child : node->children) {
+			stack1.push(child);
+		}
+	}
+
+	while (!stack2.empty()) {
+		SemanticTreeNode* node = stack2.top();
+		stack2.pop();
+
+		if (node->analyzed) {
+			restore_params(node);
+			continue;
+		}
+
+		// Process node - this can be customized as needed
+		// For example, print node information
+		if (node->leaf()) {
+			analyze_leaf(node);
+			continue;
+		}
+
+		analyze_node(node);
+		node->analyzed = true;
+	}
+}
+
+void SemanticAnalyzer::report_error(const std::string& message)
+{
+	if (!collect_errors) throw SemanticError(message);
+	errors.push_back({current_declaration, message});
+}
+
+void SemanticAnalyzer::semantic_analyze_parallel(ThreadPool& pool)
+{
+	if (root == nullptr) return;
+
+	std::vector<SemanticTreeNode*> declarations = top_level_declarations();
+	size_t count = declarations.size();
+	std::vector<size_t> temp_count(count, 0);
+	std::vector<size_t> functions;
+
+	// 全局变量按顺序在本线程分析，变量表就是之后各函数的全局作用域
+	collect_errors = true;
+	size_t first_temp = next_temp_varible_id;
+	for (size_t k = 0; k < count; ++k) {
+		const ChildList& children = declarations[k]->children;
+		if (children.size() == 1 && children[0]->literal == "fun_declaration") {
+			functions.push_back(k);
+			continue;
+		}
+		current_declaration = k;
+		next_temp_varible_id = 0;
+		analyze_subtree(declarations[k]);
+		temp_count[k] = next_temp_varible_id;
+	}
+
+	// 每个函数一个任务，任务之间只共享只读的全局变量表
+	std::vector<SemanticTreeNode*> roots(declarations);
+	std::vector<std::unique_ptr<SemanticAnalyzer>> analyzers(count);
+	pool.parallel_for(functions.size(), [&](size_t i) {
+		size_t k = functions[i];
+		auto analyzer = std::make_unique<SemanticAnalyzer>(roots[k], productions);
+		analyzer->handlers = handlers;
+		analyzer->collect_errors = true;
+		analyzer->global_scope = this;
+		analyzer->current_declaration = k;
+		analyzer->analyze_subtree(declarations[k]);
+		temp_count[k] = analyzer->next_temp_varible_id;
+		analyzers[k] = std::move(analyzer);
+	});
+
+	// 按声明顺序统一给临时变量编号
+	std::vector<size_t> offsets(count);
+	size_t offset = first_temp;
+	for (size_t k = 0; k < count; ++k) {
+		offsets[k] = offset;
+		offset += temp_count[k];
+	}
+	// 各声明中的临时变量从 0 开始编号，合并时加上排在它前面的临时变量总数；函数的名字和常量换成本分析器中的编号
+	for (size_t k = 0; k < count; ++k) {
+		const SemanticAnalyzer* source = analyzers[k].get();
+		const Interner& names = source != nullptr ? source->interner : interner;
+		auto renumber = [&](Operand operand) { return interner.import(names, operand, offsets[k]); };
+		auto rewrite = [&](Quater& quater) {
+			quater.arg1 = renumber(quater.arg1);
+			quater.arg2 = renumber(quater.arg2);
+			quater.result = renumber(quater.result);
+		};
+		// 函数的代码在它自己的 IRBuffer 中，复制到本分析器的缓冲区；全局变量的代码原地修改
+		if (source != nullptr) {
+			declarations[k]->code = ir.import(source->ir, declarations[k]->code, rewrite);
+		} else {
+			ir.update(declarations[k]->code, rewrite);
+		}
+	}
+	for (auto& [name, meta] : varible_table) {
+		meta.value = interner.import(interner, meta.value, offsets[meta.declaration]);
+	}
+
+	// 合并各函数的局部变量和错误，同名的变量只保留最先声明的一个(与顺序分析相同)
+	for (size_t k : functions) {
+		for (auto& [name, meta] : analyzers[k]->varible_table) {
+			meta.value = interner.import(analyzers[k]->interner, meta.value, offsets[k]);
+			auto [it, inserted] = varible_table.emplace(name, meta);
+			if (!inserted && it->second.declaration > meta.declaration) {
+				bool ambiguous = it->second.ambiguous;
+				it->second = meta;
+				it->second.ambiguous = it->second.ambiguous || ambiguous;
+			} else if (!inserted) {
+				it->second.ambiguous = it->second.ambiguous || meta.ambiguous;
+			}
+		}
+		errors.insert(errors.end(), analyzers[k]->errors.begin(), analyzers[k]->errors.end());
+	}
+
+	// 各任务只比较了自己函数中的声明，不同函数(以及全局变量)之间按名字比较类型；名字的编号各不相同，按文本合并
+	std::unordered_map<std::string, std::string> types;
+	std::unordered_set<std::string> ambiguous;
+	auto merge_names = [&](const SemanticAnalyzer& source) {
+		for (const auto& [id, declaration] : source.declared_names) {
+			const std::string& name = source.interner.name(id);
+			auto [it, inserted] = types.emplace(name, declaration.type);
+			if (source.ambiguous_names.count(id) > 0 || (!inserted && it->second != declaration.type)) ambiguous.insert(name);
+		}
+	};
+	merge_names(*this);
+	for (size_t k : functions) {
+		merge_names(*analyzers[k]);
+	}
+	for (const std::string& name : ambiguous) {
+		auto it = varible_table.find(name);
+		if (it != varible_table.end()) it->second.ambiguous = true;
+	}
+
+	next_temp_varible_id = offset;
+	collect_errors = false;
+
+	if (!errors.empty()) {
+		std::stable_sort(errors.begin(), errors.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		std::string message;
+		for (const auto& error : errors) {
+			message += (message.empty() ? "" : "\n") + error.second;
+		}
+		errors.clear();
+		throw SemanticError(message);
+	}
+
+	// 外层的 declaration_list、program 只合并各声明的结果
+	semantic_analyze();
+	collect_declaration_code(declarations);
+}
+
+std::vector<SemanticTreeNode*> SemanticAnalyzer::top_level_declarations() const
+{
+	std::vector<SemanticTreeNode*> declarations;
+	std::stack<SemanticTreeNode*> pending;
+	if (root != nullptr) pending.push(root);
+	while (!pending.empty()) {
+		SemanticTreeNode* node = pending.top();
+		pending.pop();
+		if (node->literal == "declaration") {
+			declarations.push_back(node);
+			continue;
+		}
+		for (size_t i = node->children.size(); i > 0; --i) {
+			pending.push(node->children[i - 1]);
+		}
+	}
+	return declarations;
+}
+
+void SemanticAnalyzer::collect_declaration_code(const std::vector<SemanticTreeNode*>& declarations)
+{
+	declaration_code.clear();
+	for (SemanticTreeNode* declaration : declarations) {
+		// declaration ::= fun_declaration，函数名是 fun_declaration 的第二个子结点
+		const SemanticTreeNode* child = declaration->children[0];
+		bool function = child->literal == "fun_declaration";
+		declaration_code.push_back({function ? child->children[1]->real_value : "", declaration->code.size});
+	}
+}
+
+std::vector<FunctionRange> SemanticAnalyzer::get_functions() const
+{
+	std::vector<FunctionRange> functions;
+	size_t position = 0;
+	for (const auto& [name, size] : declaration_code) {
+		if (!name.empty()) functions.push_back({name, position, position + size});
+		position += size;
+	}
+	return functions;
+}
+
+void SemanticAnalyzer::reanalyze(SemanticTreeNode* new_root)
+{
+	root = new_root;
+	++generation;
+	semantic_analyze();
+	// 复用的顶层声明不会再次归约
+	collect_declaration_code(top_level_declarations());
+}
+
+void SemanticAnalyzer::semantic_analyze(const CompactTree& tree)
+{
+	if (tree.empty()) return;
+
+	// 属性栈：紧凑树中结点按后序排列，处理到某个结点时，它的子结点恰好是栈顶的若干项
+	std::vector<SemanticTreeNode*> attributes;
+
+	for (uint32_t id = 0; id < tree.size(); ++id) {
+		SemanticTreeNode* node = acquire_node(Symbol(tree.symbol(id).type, tree.symbol(id).literal, tree.token_value(id)));
+		node->production_id = tree.production_id[id];
+		size_t count = tree.child_count[id];
+
+		// 叶子按后序出现的顺序就是 token 的顺序
+		node->token_begin = node->token_end = static_cast<uint32_t>(token_offset.size() - 1);
+		if (node->type == SymbolType::Terminal) {
+			record_token(node->real_value);
+			node->token_end = node->token_begin + 1;
+			analyze_leaf(node);
+		}
+
+		if (count > 0) {
+			node->children.data = attributes.data() + attributes.size() - count;
+			node->children.count = count;
+			node->token_begin = node->children[0]->token_begin;
+			node->token_end = node->children[count - 1]->token_end;
+			analyze_node(node);
+
+			// 子结点的属性已经合并到父结点，回收
+			for (SemanticTreeNode* child : node->children) {
+				release_node(child);
+			}
+			node->children = ChildList();
+			attributes.resize(attributes.size() - count);
+		}
+		attributes.push_back(node);
+	}
+
+	root = attributes.back();
+}
+
+bool SemanticAnalyzer::translate(const LR1Parser& parser,
+                                 const TokenSource& next_token,
+                                 Arena& arena,
+                                 std::exception_ptr& semantic_error,
+                                 bool keep_tree)
+{
+	semantic_error = nullptr;
+	const auto& productions = parser.get_productions();
+	std::vector<SemanticAction> actions(productions.size());
+	for (size_t i = 0; i < productions.size(); ++i) {
+		actions[i] = until_error([this](SemanticTreeNode* node) { analyze_node(node); }, semantic_error);
+	}
+
+	// 子结点在归约后即被回收，记下读到的 token，需要源代码文本时按结点的 token 范围取出
+	TokenSource recording_token = [this, &next_token]() {
+		Symbol token = next_token();
+		record_token(token.real_value);
+		return token;
+	};
+
+	SemanticAction on_shift = until_error([this](SemanticTreeNode* node) { analyze_leaf(node); }, semantic_error);
+
+	root = nullptr;
+	return parser.parse(recording_token, actions, on_shift, root, arena, keep_tree);
+}
+
+bool SemanticAnalyzer::translate_streaming(const LR1Parser& parser,
+                                           const TokenSource& next_token,
+                                           Arena& arena,
+                                           const DeclarationSink& sink,
+                                           std::exception_ptr& semantic_error)
+{
+	semantic_error = nullptr;
+	const auto& productions = parser.get_productions();
+	std::vector<SemanticAction> actions(productions.size());
+	for (size_t i = 0; i < productions.size(); ++i) {
+		if (productions[i].lhs.literal == "declaration") {
+			actions[i] = until_error(
+			    [this, &sink](SemanticTreeNode* node) {
+				    analyze_node(node);
+				    finish_declaration(node, sink);
+			    },
+			    semantic_error);
+		} else {
+			actions[i] = until_error([this](SemanticTreeNode* node) { analyze_node(node); }, semantic_error);
+		}
+	}
+
+	TokenSource recording_token = [this, &next_token]() {
+		Symbol token = next_token();
+		record_token(token.real_value);
+		return token;
+	};
+
+	SemanticAction on_shift = until_error([this](SemanticTreeNode* node) { analyze_leaf(node); }, semantic_error);
+
+	root = nullptr;
+	return parser.parse(recording_token, actions, on_shift, root, arena, false);
+}
+
+void SemanticAnalyzer::finish_declaration(SemanticTreeNode* node, const DeclarationSink& sink)
+{
+	// 声明的代码在 declaration_code 中已经记下长度，get_functions() 仍按它计算范围
+	// 归约到这里时缓冲区中只有这个声明的四元式(叶子和未完成的结点不生成代码)，可以整个清空
+	std::vector<std::pair<size_t, Quater>> code = ir.flatten(node->code, emitted_quads);
+	sink(code, declaration_code.back().first);
+	emitted_quads += code.size();
+	node->code = IRCode();
+	ir.clear();
+
+	// 向前看的 token 已经读入，它属于下一个声明，保留
+	discard_tokens(node->token_end);
+}
+
+void SemanticAnalyzer::analyze_node(SemanticTreeNode* node)
+{
+	Handler handler = node->production_id < handlers.size() ? handlers[node->production_id] : &SemanticAnalyzer::handle_defalt;
+	(this->*handler)(node);
+
+	if (node->children.size() == 1 && node->children[0]->literal == "T_IDENTIFIER") {
+		node->literal = node->children[0]->literal;
+	}
+}
+
+void SemanticAnalyzer::analyze_leaf(SemanticTreeNode* node)
+{
+	if (node->literal != "T_LEFT_BRACE") return;
+
+	// compound_stmt 归约时退出；函数体的作用域同时包含形参
+	symbols.push_scope();
+	declare_pending_params();
+}
+
+void SemanticAnalyzer::declare_pending_params()
+{
+	for (const auto& [name, meta] : pending_params) {
+		note_declaration(name.index(), meta.type);
+		if (symbols.declare(name.index(), meta) != nullptr) report_error("Error：重定义变量：" + interner.name(name.index()));
+	}
+	pending_params.clear();
+}
+
+SemanticTreeNode* SemanticAnalyzer::acquire_node(const Symbol& symbol)
+{
+	if (free_nodes.empty()) {
+		return node_arena.create<SemanticTreeNode>(symbol);
+	}
+	SemanticTreeNode* node = free_nodes.back();
+	free_nodes.pop_back();
+	*node = SemanticTreeNode(symbol);
+	return node;
+}
+
+void SemanticAnalyzer::release_node(SemanticTreeNode* node)
+{
+	free_nodes.push_back(node);
+}
+
+Operand SemanticAnalyzer::operand_of(SemanticTreeNode* node)
+{
+	// 紧凑树和归约时翻译的模式下，分析完的结点会丢掉子结点，所以按符号种类而不是 leaf() 判断
+	if (node->type != SymbolType::Terminal) return node->place;
+
+	// 运算符、分隔符等终结符没有值
+	const std::string& type = node->literal;
+	if (type == "T_IDENTIFIER") return interner.variable(node->real_value);
+	if (type == "T_INTEGER_LITERAL") return interner.constant(Operand::Kind::INT, node->real_value);
+	if (type == "T_FLOAT_LITERAL") return interner.constant(Operand::Kind::FLOAT, node->real_value);
+	if (type == "T_CHAR_LITERAL") return interner.constant(Operand::Kind::CHAR, node->real_value);
+	if (type == "T_STRING_LITERAL") return interner.constant(Operand::Kind::STRING, node->real_value);
+	return Operand();
+}
+
+Opcode SemanticAnalyzer::token_opcode(SemanticTreeNode* node)
+{
+	static const std::unordered_map<std::string, Opcode> opcodes = {
+	    {"T_ASSIGN", Opcode::ASSIGN},     {"T_PLUS", Opcode::ADD},           {"T_MINUS", Opcode::SUB},
+	    {"T_MULTIPLY", Opcode::MUL},      {"T_DIVIDE", Opcode::DIV},         {"T_MOD", Opcode::MOD},
+	    {"T_BITAND", Opcode::BITAND},     {"T_BITOR", Opcode::BITOR},        {"T_BITXOR", Opcode::BITXOR},
+	    {"T_LEFTSHIFT", Opcode::SHL},     {"T_RIGHTSHIFT", Opcode::SHR},     {"T_LESS", Opcode::LESS},
+	    {"T_GREATER", Opcode::GREATER},   {"T_EQUAL", Opcode::EQUAL},        {"T_NOTEQUAL", Opcode::NOT_EQUAL},
+	    {"T_LESSEQUAL", Opcode::LESS_EQUAL}, {"T_GREATEREQUAL", Opcode::GREATER_EQUAL},
+	    {"T_AND", Opcode::AND},           {"T_OR", Opcode::OR},              {"T_NOT", Opcode::NOT},
+	    {"T_BITNOT", Opcode::BITNOT},     {"T_INCREMENT", Opcode::ADD},      {"T_DECREMENT", Opcode::SUB},
+	};
+
+	if (node->type != SymbolType::Terminal) return node->op;
+	auto it = opcodes.find(node->literal);
+	return it != opcodes.end() ? it->second : Opcode::COUNT;
+}
+
+Opcode SemanticAnalyzer::opcode_of(SemanticTreeNode* node)
+{
+	Opcode op = token_opcode(node);
+	if (op == Opcode::COUNT) {
+		report_error("Error: 不支持的运算符：" + source_text(node));
+		return Opcode::ASSIGN;
+	}
+	return op;
+}
+
+void SemanticAnalyzer::record_token(const std::string& text)
+{
+	token_text += text;
+	token_offset.push_back(static_cast<uint32_t>(token_text.size()));
+}
+
+void SemanticAnalyzer::discard_tokens(uint32_t end)
+{
+	if (end <= token_base || end - token_base >= token_offset.size()) return;
+	size_t count = end - token_base;
+	uint32_t shift = token_offset[count];
+	token_text.erase(0, shift);
+	token_offset.erase(token_offset.begin(), token_offset.begin() + count);
+	for (uint32_t& offset : token_offset) {
+		offset -= shift;
+	}
+	token_base = end;
+}
+
+std::string SemanticAnalyzer::source_text(const SemanticTreeNode* node) const
+{
+	if (node->type == SymbolType::Terminal) return node->real_value;
+	if (node->children.empty()) {
+		// 子结点已经回收，从记录的 token 中取
+		if (node->token_begin < token_base || node->token_end - token_base >= token_offset.size()) return "";
+		uint32_t begin = token_offset[node->token_begin - token_base];
+		return token_text.substr(begin, token_offset[node->token_end - token_base] - begin);
+	}
+
+	std::string text;
+	for (const SemanticTreeNode* child : node->children) {
+		text += source_text(child);
+	}
+	return text;
+}
+
+void SemanticAnalyzer::append_children_code(SemanticTreeNode* node)
+{
+	for (const auto& child : node->children) {
+		ir.append(node->code, child->code);
+	}
+}
+
+void SemanticAnalyzer::handle_defalt(SemanticTreeNode*& node)
+{
+	append_children_code(node);
+	// relop、addop 等只含一个运算符的结点
+	if (node->children.size() == 1) {
+		node->op = token_opcode(node->children[0]);
+	}
+
+	for (const auto& child : node->children) {
+		Operand value = operand_of(child);
+		if (!value.empty()) {
+			node->place = value;
+			break;
+		}
+	}
+}
+
+void SemanticAnalyzer::declare(const std::string& name, const VaribleMeta& meta)
+{
+	uint32_t id = interner.variable(name).index();
+	note_declaration(id, meta.type);
+	VaribleMeta* previous = symbols.declare(id, meta);
+	if (previous != nullptr) {
+		// 如果本轮分析中已经在同一作用域声明过这个变量，报错；上一轮留下的声明直接覆盖
+		if (previous->generation == generation) {
+			report_error("Error：重定义变量：" + name);
+			return;
+		}
+		*previous = meta;
+	}
+
+	auto it = varible_table.find(name);
+	if (it == varible_table.end() || it->second.generation != generation) {
+		// 之前各轮发现的歧义仍然保留
+		bool ambiguous = it != varible_table.end() && it->second.ambiguous;
+		it = varible_table.insert_or_assign(name, meta).first;
+		it->second.ambiguous = ambiguous;
+	}
+	if (ambiguous_names.count(id) > 0) it->second.ambiguous = true;
+}
+
+void SemanticAnalyzer::note_declaration(uint32_t name, const std::string& type)
+{
+	// 遮蔽了当前可见的同名变量；并行分析的函数任务中还要看在它之前声明的全局变量
+	bool ambiguous = symbols.lookup(name) != nullptr;
+	if (global_scope != nullptr) {
+		Operand global = global_scope->interner.find_variable(interner.name(name));
+		const VaribleMeta* meta = global.empty() ? nullptr : global_scope->symbols.lookup(global.index());
+		ambiguous = ambiguous || (meta != nullptr && meta->declaration < current_declaration);
+	}
+
+	auto [it, inserted] = declared_names.try_emplace(name, NameDeclaration{type, declaration_code.size()});
+	if (!inserted) {
+		ambiguous = ambiguous || it->second.declaration == declaration_code.size() || it->second.type != type;
+		it->second.declaration = declaration_code.size();
+	}
+	if (!ambiguous) return;
+
+	ambiguous_names.insert(name);
+	auto entry = varible_table.find(interner.name(name));
+	if (entry != varible_table.end()) entry->second.ambiguous = true;
+}
+
+bool SemanticAnalyzer::is_declared(Operand name) const
+{
+	if (symbols.lookup(name.index()) != nullptr) return true;
+
+	// 并行分析的函数任务：全局变量在主分析器的表中，名字编号也要换成它的
+	if (global_scope != nullptr) {
+		Operand global = global_scope->interner.find_variable(interner.name(name.index()));
+		const VaribleMeta* meta = global.empty() ? nullptr : global_scope->symbols.lookup(global.index());
+		if (meta != nullptr && meta->declaration < current_declaration) return true;
+	}
+
+	// 增量分析时复用的子树不会重新登记其中的声明，退回到之前各轮记下的变量表
+	return generation > 0 && varible_table.count(interner.name(name.index())) > 0;
+}
+
+void SemanticAnalyzer::declare_variable(SemanticTreeNode* node, Operand init_val)
+{
+	const auto& list = node->children;
+	declare(list[1]->real_value, {source_text(list[0]), init_val, generation, current_declaration});
+}
+
+void SemanticAnalyzer::handle_var_declaration(SemanticTreeNode*& node)
+{
+	// type_specifier T_IDENTIFIER T_SEMICOLON
+	// type_specifier T_IDENTIFIER T_LEFT_SQUARE T_INTEGER_LITERAL T_RIGHT_SQUARE T_SEMICOLON
+	declare_variable(node, Operand());
+}
+
+void SemanticAnalyzer::handle_initialized_declaration(SemanticTreeNode*& node)
+{
+	// type_specifier T_IDENTIFIER opt_init T_SEMICOLON
+	append_children_code(node);
+	declare_variable(node, operand_of(node->children[2]));
+}
+
+void SemanticAnalyzer::handle_opt_init(SemanticTreeNode*& node)
+{
+	// T_ASSIGN expression
+	append_children_code(node);
+	node->place = operand_of(node->children[1]);
+}
+
+void SemanticAnalyzer::handle_assignment(SemanticTreeNode*& node)
+{
+	/*
+	var T_ASSIGN expression
+	a = exp
+	(=, t, _, a)
+	*/
+	const auto& list = node->children;
+	append_children_code(node);
+
+	// 只由一个标识符构成的结点被改记为 T_IDENTIFIER，它的值就是这个变量名
+	for (SemanticTreeNode* side : {list[0], list[2]}) {
+		if (side->literal != "T_IDENTIFIER") continue;
+		Operand name = operand_of(side);
+		if (!is_declared(name)) report_error("Error: 未定义变量：" + interner.name(name.index()));
+	}
+	node->place = operand_of(list[0]);
+	emit(node, opcode_of(list[1]), operand_of(list[2]), Operand(), node->place);
+}
+
+void SemanticAnalyzer::handle_binary_expression(SemanticTreeNode*& node)
+{
+	/*
+	additive_expression relop additive_expression
+	simple_expression relop simple_expression
+	additive_expression addop term
+	term mulop factor
+	*/
+	const auto& list = node->children;
+	append_children_code(node);
+
+	Operand new_temp = new_temp_varible();
+	emit(node, opcode_of(list[1]), operand_of(list[0]), operand_of(list[2]), new_temp);
+	node->place = new_temp;
+}
+
+void SemanticAnalyzer::handle_factor(SemanticTreeNode*& node)
+{
+	// T_LEFT_PAREN expression T_RIGHT_PAREN
+	append_children_code(node);
+	node->place = operand_of(node->children[1]);
+}
+
+// 函数调用和数组元素还不翻译，整体作为一个复合操作数(实参列表同样处理，供外层的调用使用)
+
+void SemanticAnalyzer::handle_call(SemanticTreeNode*& node)
+{
+	// T_IDENTIFIER T_LEFT_PAREN args T_RIGHT_PAREN
+	const auto& list = node->children;
+	append_children_code(node);
+	node->place = interner.compound(Compound::Shape::CALL, operand_of(list[0]), operand_of(list[2]));
+}
+
+void SemanticAnalyzer::handle_call_without_args(SemanticTreeNode*& node)
+{
+	// T_IDENTIFIER T_LEFT_PAREN T_RIGHT_PAREN
+	node->place = interner.compound(Compound::Shape::CALL, operand_of(node->children[0]), Operand());
+}
+
+void SemanticAnalyzer::handle_arg_list(SemanticTreeNode*& node)
+{
+	// arg_list T_COMMA expression
+	const auto& list = node->children;
+	append_children_code(node);
+	node->place = interner.compound(Compound::Shape::LIST, operand_of(list[0]), operand_of(list[2]));
+}
+
+void SemanticAnalyzer::handle_array_element(SemanticTreeNode*& node)
+{
+	// T_IDENTIFIER T_LEFT_SQUARE expression T_RIGHT_SQUARE
+	const auto& list = node->children;
+	append_children_code(node);
+	node->place = interner.compound(Compound::Shape::INDEX, operand_of(list[0]), operand_of(list[2]));
+}
+
+void SemanticAnalyzer::handle_prefix_increment(SemanticTreeNode*& node)
+{
+	/*
+	inc_dec_operator var   ++a
+	(+, a, 1, a)
+	*/
+	const auto& list = node->children;
+	append_children_code(node);
+
+	// ++、-- 分别记为 +、-
+	Operand varible = operand_of(list[1]);
+	emit(node, opcode_of(list[0]), varible, interner.constant(Operand::Kind::INT, "1"), varible);
+	node->place = varible;
+}
+
+void SemanticAnalyzer::handle_prefix_expression(SemanticTreeNode*& node)
+{
+	/*
+	T_NOT factor
+	T_BITNOT factor
+	(~/!, a, _, t1)
+	*/
+	const auto& list = node->children;
+	append_children_code(node);
+
+	Operand new_temp = new_temp_varible();
+	emit(node, opcode_of(list[0]), operand_of(list[1]), Operand(), new_temp);
+	node->place = new_temp;
+}
+
+void SemanticAnalyzer::handle_postfix_expression(SemanticTreeNode*& node)
+{
+	/*
+	var inc_dec_operator   			a++, b--
+
+	(=, a, _, t1)
+	(++, a, _, a)
+	*/
+	const auto& list = node->children;
+	append_children_code(node);
+
+	Operand varible = operand_of(list[0]);
+	Opcode op = opcode_of(list[1]);
+
+	Operand new_temp = new_temp_varible();
+	emit(node, Opcode::ASSIGN, varible, Operand(), new_temp);
+	emit(node, op, varible, interner.constant(Operand::Kind::INT, "1"), varible);
+
+	node->place = new_temp;
+}
+
+// 语句的代码顺序与子结点顺序不同，由动作自己合并子结点的代码
+
+void SemanticAnalyzer::handle_if(SemanticTreeNode*& node)
+{
+	// T_IF T_LEFT_PAREN expression T_RIGHT_PAREN statement
+	const auto& list = node->children;
+
+	ir.append(node->code, list[2]->code);
+
+	// 条件为真跳到 THEN，否则跳到 ENDIF
+	JumpList true_list, next_list;
+	ir.emit_jump(node->code, Opcode::JNZ, operand_of(list[2]), true_list);
+	ir.emit_jump(node->code, Opcode::JUMP, Operand(), next_list);
+
+	ir.backpatch(true_list, node->code.size);
+	ir.append(node->code, list[4]->code);
+	ir.backpatch(next_list, node->code.size);
+}
+
+void SemanticAnalyzer::handle_if_else(SemanticTreeNode*& node)
+{
+	// T_IF T_LEFT_PAREN expression T_RIGHT_PAREN statement T_ELSE statement
+	const auto& list = node->children;
+
+	ir.append(node->code, list[2]->code);
+
+	// 条件为真跳到 THEN，否则顺序执行 ELSE
+	JumpList true_list, next_list;
+	ir.emit_jump(node->code, Opcode::JNZ, operand_of(list[2]), true_list);
+	ir.append(node->code, list[6]->code);
+	ir.emit_jump(node->code, Opcode::JUMP, Operand(), next_list);
+
+	ir.backpatch(true_list, node->code.size);
+	ir.append(node->code, list[4]->code);
+	ir.backpatch(next_list, node->code.size);
+}
+
+void SemanticAnalyzer::handle_while(SemanticTreeNode*& node)
+{
+	// T_WHILE T_LEFT_PAREN expression T_RIGHT_PAREN statement
+	const auto& list = node->children;
+
+	JumpList true_list, false_list;
+	uint32_t LOOP = node->code.size;
+	ir.append(node->code, list[2]->code);
+	ir.emit_jump(node->code, Opcode::JNZ, operand_of(list[2]), true_list);
+	ir.emit_jump(node->code, Opcode::JUMP, Operand(), false_list);
+	ir.backpatch(true_list, node->code.size);
+	ir.append(node->code, list[4]->code);
+	ir.emit_jump(node->code, Opcode::JUMP, Operand(), LOOP);
+	ir.backpatch(false_list, node->code.size);
+}
+
+void SemanticAnalyzer::handle_for(SemanticTreeNode*& node)
+{
+	// T_FOR T_LEFT_PAREN opt_expression_stmt opt_expression_stmt expression T_RIGHT_PAREN statement
+	const auto& list = node->children;
+	const auto& exp1 = list[2];
+	const auto& exp2 = list[3];
+	const auto& exp3 = list[4];
+	const auto& stmt = list[6];
+
+	JumpList true_list, false_list;
+	ir.append(node->code, exp1->code);
+	uint32_t START = node->code.size;
+	ir.append(node->code, exp2->code);
+	ir.emit_jump(node->code, Opcode::JNZ, operand_of(exp2), true_list);
+	ir.emit_jump(node->code, Opcode::JUMP, Operand(), false_list);
+	ir.backpatch(true_list, node->code.size);
+	ir.append(node->code, stmt->code);
+	ir.append(node->code, exp3->code);
+	ir.emit_jump(node->code, Opcode::JUMP, Operand(), START);
+	ir.backpatch(false_list, node->code.size);
+}
+
+void SemanticAnalyzer::handle_compound_stmt(SemanticTreeNode*& node)
+{
+	// T_LEFT_BRACE block_items T_RIGHT_BRACE
+	// T_LEFT_BRACE T_RIGHT_BRACE
+	handle_defalt(node);
+	symbols.pop_scope();
+}
+
+void SemanticAnalyzer::handle_param(SemanticTreeNode*& node)
+{
+	// type_specifier T_IDENTIFIER
+	// type_specifier T_IDENTIFIER T_LEFT_SQUARE T_RIGHT_SQUARE
+	// 形参不记入输出的变量表，只在函数体中可见
+	handle_defalt(node);
+	add_param(node);
+}
+
+void SemanticAnalyzer::add_param(SemanticTreeNode* param)
+{
+	const auto& list = param->children;
+	pending_params.push_back({operand_of(list[1]), {source_text(list[0]), Operand(), generation, current_declaration}});
+}
+
+void SemanticAnalyzer::restore_params(SemanticTreeNode* reused)
+{
+	// param_list 左递归，按从左到右的顺序找出其中的 param
+	std::vector<SemanticTreeNode*> stack = {reused};
+	while (!stack.empty()) {
+		SemanticTreeNode* node = stack.back();
+		stack.pop_back();
+		if (node->literal == "param") {
+			add_param(node);
+			continue;
+		}
+		for (size_t i = node->children.size(); i > 0; --i) {
+			if (!node->children[i - 1]->leaf()) stack.push_back(node->children[i - 1]);
+		}
+	}
+}
+
+void SemanticAnalyzer::handle_global_declaration(SemanticTreeNode*& node)
+{
+	// var_declaration
+	handle_defalt(node);
+	declaration_code.push_back({"", node->code.size});
+}
+
+void SemanticAnalyzer::handle_fun_declaration(SemanticTreeNode*& node)
+{
+	// type_specifier T_IDENTIFIER T_LEFT_PAREN params T_RIGHT_PAREN compound_stmt
+	// type_specifier T_IDENTIFIER T_LEFT_PAREN T_RIGHT_PAREN compound_stmt
+	handle_defalt(node);
+	// 增量分析只改了形参、复用了整个函数体时，函数体的 T_LEFT_BRACE 没有再分析，
+	// 在这里检查形参的重定义，并且不能让它们留到下一个函数
+	if (!pending_params.empty()) {
+		symbols.push_scope();
+		declare_pending_params();
+		symbols.pop_scope();
+	}
+	declaration_code.push_back({node->children[1]->real_value, node->code.size});
+}
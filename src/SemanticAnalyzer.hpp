@@ -1,57 +1,200 @@
-#pragma once
-#include "LR1Parser.hpp"
-#include <iomanip>
-
-struct VaribleMeta
-{
-	std::string type;   // 变量类型，int，float，char等
-	std::string value;  // 变量的值，为了简化操作，全部存为string，在需要使用时进行转换
-};
-
-
-class SemanticAnalyzer {
-public:
-	SemanticAnalyzer(SemanticTreeNode*& root) : root(root), next_temp_varible_id(0) {}
-
-	void semantic_analyze();
-	void print_intermediate_code();
-	void print_variable_table();
-
-private:
-	void handle_defalt(SemanticTreeNode*& node);
-	void handle_var_declaration(SemanticTreeNode*& node);
-	void handle_opt_init(SemanticTreeNode*& node);
-	void handle_expression(SemanticTreeNode*& node);
-	void handle_simple_expression(SemanticTreeNode*& node);
-	void handle_additive_expression(SemanticTreeNode*& node);
-	void handle_term(SemanticTreeNode*& node);
-	void handle_postfix_expression(SemanticTreeNode*& node);
-	void handle_var(SemanticTreeNode*& node);
-	void handle_factor(SemanticTreeNode*& node);
-	void handle_prefix_expression(SemanticTreeNode*& node);
-	void handle_selection_stmt(SemanticTreeNode*& node);
-	void handle_iteration_stmt(SemanticTreeNode*& node);
-	void handle_opt_expression_stmt(SemanticTreeNode*& node);
-
-private:
-	std::string
-	new_temp_varible()
-	{
-		return "t" + std::to_string(next_temp_varible_id++);
-	}
-
-private:
-	bool exists_var_declaration(std::string var)
-	{
-		return varible_table.find(var) != varible_table.end();
-	}
-
-private:
-	SemanticTreeNode* root;
-
-	std::map<std::string, VaribleMeta> varible_table;  // 变量表，存储已经声明过的变量
-
-	std::vector<std::pair<size_t, Quater>> intermediate_code() { return root->quater_list; }  // 中间代码，一个数字编号，一个四元式
-
-	size_t next_temp_varible_id;
+#pragma once
+#include "LR1Parser.hpp"
+#include "CompactTree.hpp"
+#include "Interner.hpp"
+#include "SymbolTable.hpp"
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+// 语义错误(重定义、未定义变量等)，由调用者决定如何报告，分析器自身不退出进程
+class SemanticError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+class ThreadPool;
+
+class SemanticAnalyzer {
+public:
+	// 语义动作：对一个子结点已经处理完毕的内部结点计算属性、生成代码
+	using Handler = void (SemanticAnalyzer::*)(SemanticTreeNode*&);
+	// 流式翻译时接收一个顶层声明的代码：编号(包括跳转目标)按整个文件连续，function 为函数名，全局变量的声明为空
+	using DeclarationSink = std::function<void(const std::vector<std::pair<size_t, Quater>>& code, const std::string& function)>;
+
+	// productions 为语法分析器的产生式表，结点的 production_id 是其中的下标
+	SemanticAnalyzer(SemanticTreeNode*& root, const std::vector<Production>& productions);
+
+	// 为产生式 rule 注册语义动作(写法与文法文件相同，如 "factor ::= T_LEFT_PAREN expression T_RIGHT_PAREN")，
+	// 替换原来的动作；文法中没有这个产生式时返回 false
+	bool register_handler(const std::string& rule, Handler handler);
+
+	void semantic_analyze();
+	// 只分析 subtree 这棵子树，已经分析过的结点会被跳过
+	// 流水线中语法分析器每归约出一个顶层声明就交给语义线程分析，最后再对整棵树调用 semantic_analyze()
+	void analyze_subtree(SemanticTreeNode* subtree);
+	// 增量分析：对 LR1Parser::reparse 得到的新树重新分析，只处理新建的结点，
+	// 复用子树上已经算好的属性直接参与合并；临时变量编号继续递增，不会和复用部分冲突
+	// 注意：被删除的声明仍留在变量表中，直到下一次完整分析
+	void reanalyze(SemanticTreeNode* new_root);
+	// 按后序线性扫描紧凑语法树，用属性栈代替指针树上的两次栈遍历
+	void semantic_analyze(const CompactTree& tree);
+	// 语法制导翻译：语义动作按产生式编号注册到语法分析器，归约时直接执行，省去单独的树遍历
+	// 返回语法分析是否成功；语义错误不中止语法分析，第一个错误保存在 semantic_error 中，之后只做语法分析，
+	// 由调用者在报告语法分析结果之后重新抛出，与先建树再分析时的输出顺序相同
+	bool translate(const LR1Parser& parser,
+	               const TokenSource& next_token,
+	               Arena& arena,
+	               std::exception_ptr& semantic_error,
+	               bool keep_tree = false);
+	// 流式翻译：同 translate，但每归约出一个顶层声明就把它的代码交给 sink，随即丢掉它的四元式和读过的 token 文本，
+	// 内存只与最大的一个声明有关；完成后 get_intermediate_code() 为空，变量表和 get_functions() 照常可用
+	bool translate_streaming(const LR1Parser& parser,
+	                         const TokenSource& next_token,
+	                         Arena& arena,
+	                         const DeclarationSink& sink,
+	                         std::exception_ptr& semantic_error);
+	// 并行分析：全局变量的声明在当前线程按顺序分析，每个 fun_declaration 作为独立任务在 pool 中分析
+	// 任务有自己的局部变量表和临时变量计数，只读地查找在它之前声明的全局变量(局部变量可以遮蔽全局变量)
+	// 临时变量先在各自的声明内编号，全部完成后按声明顺序统一重新编号，因此输出与顺序分析相同
+	// 各任务的名字和常量驻留在自己的 Interner 中，合并时换成本分析器中的编号
+	// 各声明中的错误不会中止分析，而是按声明顺序收集起来，最后合并成一个 SemanticError 抛出
+	void semantic_analyze_parallel(ThreadPool& pool);
+	void print_intermediate_code(std::ostream& out = std::cout) { print_intermediate_code(get_intermediate_code(), interner, out); }
+	void print_variable_table(std::ostream& out = std::cout) { print_variable_table(varible_table, interner, out); }
+	// 按同样的格式打印给定的中间代码和变量表，编译缓存命中时用来输出上次的结果
+	static void print_intermediate_code(const std::vector<std::pair<size_t, Quater>>& code, const Interner& names, std::ostream& out);
+	static void print_variable_table(const std::map<std::string, VaribleMeta>& table, const Interner& names, std::ostream& out);
+
+	// 中间代码，一个数字编号，一个四元式；每次调用都按根结点的代码链重新编号生成
+	std::vector<std::pair<size_t, Quater>> get_intermediate_code() const { return root != nullptr ? ir.flatten(root->code) : std::vector<std::pair<size_t, Quater>>(); }
+	const std::map<std::string, VaribleMeta>& get_variable_table() const { return varible_table; }
+	const Interner& get_interner() const { return interner; }  // 中间代码和变量表中操作数的名字和常量
+	// 各函数的代码在 get_intermediate_code() 中的范围，按源代码顺序
+	std::vector<FunctionRange> get_functions() const;
+
+private:
+	// 对一个子结点已经处理完毕的内部结点执行语义动作：按 production_id 在 handlers 中取出，一次间接调用
+	void analyze_node(SemanticTreeNode* node);
+	// 移进一个终结符：后序遍历中叶子出现的位置就是语法分析器移进它的时刻，T_LEFT_BRACE 在这里进入新的作用域
+	void analyze_leaf(SemanticTreeNode* node);
+	// 内置的语义动作，每个产生式(而不是每个非终结符)一个，动作中不必再判断是哪个候选式
+	static const std::vector<std::pair<const char*, Handler>>& builtin_handlers();
+
+	// 没有注册动作的产生式：合并子结点的代码，值取第一个有值的子结点
+	void handle_defalt(SemanticTreeNode*& node);
+	void append_children_code(SemanticTreeNode* node);
+
+	void handle_var_declaration(SemanticTreeNode*& node);
+	void handle_initialized_declaration(SemanticTreeNode*& node);
+	void handle_opt_init(SemanticTreeNode*& node);
+	void handle_assignment(SemanticTreeNode*& node);
+	void handle_binary_expression(SemanticTreeNode*& node);
+	void handle_postfix_expression(SemanticTreeNode*& node);
+	void handle_array_element(SemanticTreeNode*& node);
+	void handle_call(SemanticTreeNode*& node);
+	void handle_call_without_args(SemanticTreeNode*& node);
+	void handle_arg_list(SemanticTreeNode*& node);
+	void handle_factor(SemanticTreeNode*& node);
+	void handle_prefix_increment(SemanticTreeNode*& node);
+	void handle_prefix_expression(SemanticTreeNode*& node);
+	void handle_if(SemanticTreeNode*& node);
+	void handle_if_else(SemanticTreeNode*& node);
+	void handle_while(SemanticTreeNode*& node);
+	void handle_for(SemanticTreeNode*& node);
+	void handle_compound_stmt(SemanticTreeNode*& node);
+	void handle_param(SemanticTreeNode*& node);
+	void handle_global_declaration(SemanticTreeNode*& node);
+	void handle_fun_declaration(SemanticTreeNode*& node);
+
+	void declare_variable(SemanticTreeNode* node, Operand init_val);
+
+private:
+	Operand new_temp_varible() { return Operand::temp(next_temp_varible_id++); }
+	void emit(SemanticTreeNode* node, Opcode op, Operand arg1, Operand arg2, Operand result) { ir.emit(node->code, Quater(op, arg1, arg2, result)); }
+
+	// 结点的值：内部结点为语义分析得到的 place，叶子结点按 token 类型驻留为变量名或常量
+	Operand operand_of(SemanticTreeNode* node);
+	// 结点代表的运算符：终结符按 token 类型查表，非终结符取它的 op 属性，不是运算符时为 Opcode::COUNT
+	Opcode token_opcode(SemanticTreeNode* node);
+	// 同上，不是运算符时报告错误
+	Opcode opcode_of(SemanticTreeNode* node);
+
+	// 结点覆盖的源代码文本(token 直接相连)，只在类型名和错误信息中用到
+	// 子结点还在时逐个拼接叶子，子结点已被回收时按 token 范围从 token_text 中取
+	std::string source_text(const SemanticTreeNode* node) const;
+	void record_token(const std::string& text);
+	// 丢掉编号小于 end 的 token 的文本，之后不能再取它们覆盖的源代码
+	void discard_tokens(uint32_t end);
+
+	// 流式翻译中一个顶层声明分析完毕：编号后交给 sink，然后释放它的代码
+	void finish_declaration(SemanticTreeNode* node, const DeclarationSink& sink);
+
+private:
+	// 在当前作用域登记变量，并记入输出的变量表
+	void declare(const std::string& name, const VaribleMeta& meta);
+	// 记下变量或形参 name 的一次声明，与之前的同名声明有歧义时(见 VaribleMeta::ambiguous)把名字记入 ambiguous_names
+	void note_declaration(uint32_t name, const std::string& type);
+	// name 在当前位置是否可见
+	bool is_declared(Operand name) const;
+	// 把形参 param 记入 pending_params，等函数体的作用域开始时登记
+	void add_param(SemanticTreeNode* param);
+	// 增量分析复用了形参列表(或其中一部分)时不会再调用 handle_param，从复用的子树中重新取出其中的形参
+	void restore_params(SemanticTreeNode* reused);
+	// 在当前作用域登记 pending_params 中的形参，然后清空
+	void declare_pending_params();
+
+	// 顺序分析时直接抛出 SemanticError；并行分析时先记下来，继续分析
+	void report_error(const std::string& message);
+
+	// 从左到右找出所有顶层声明
+	std::vector<SemanticTreeNode*> top_level_declarations() const;
+	// 顶层声明没有按源代码顺序分析(并行、增量分析)时，从语法树重新得到 declaration_code
+	void collect_declaration_code(const std::vector<SemanticTreeNode*>& declarations);
+
+private:
+	SemanticTreeNode*& root;  // 引用调用者保存的根，语法分析完成后根才确定
+
+	const std::vector<Production>& productions;
+	std::vector<Handler> handlers;  // 按产生式编号索引的语义动作，未注册的为 handle_defalt
+
+	// 输出的变量表，记录分析过的所有声明；不同作用域中的同名变量只保留最先声明的一个
+	std::map<std::string, VaribleMeta> varible_table;
+	SymbolTable symbols;  // 按作用域查找变量，只含当前位置可见的声明
+	std::vector<std::pair<Operand, VaribleMeta>> pending_params;  // 形参在函数体的作用域开始时登记
+	// 各顶层声明的函数名(全局变量为空)和代码长度，按源代码顺序；根结点的代码就是它们依次相连
+	std::vector<std::pair<std::string, uint32_t>> declaration_code;
+	// 每个名字第一次声明时的类型，以及最后一次声明时已经完成的顶层声明个数(同一函数中的声明这个数相同)
+	struct NameDeclaration
+	{
+		std::string type;
+		size_t declaration;
+	};
+	std::unordered_map<uint32_t, NameDeclaration> declared_names;
+	std::unordered_set<uint32_t> ambiguous_names;
+	Interner interner;  // 四元式和变量表中的名字、常量
+	IRBuffer ir;        // 所有结点的四元式，结点只记录自己的代码由哪几段组成
+
+	// 紧凑树和归约时翻译的模式下读到的 token，第 i 个为 token_text[token_offset[i - token_base], token_offset[i - token_base + 1])
+	// 流式翻译时前面的 token 随声明一起丢掉，token_base 为第一个还保留的 token 的编号
+	std::string token_text;
+	std::vector<uint32_t> token_offset{0};
+	uint32_t token_base = 0;
+	size_t emitted_quads = 0;  // 流式翻译已交给 sink 的四元式个数
+
+	size_t next_temp_varible_id;
+	size_t generation = 0;  // 当前是第几轮(增量)分析
+
+	size_t current_declaration = 0;  // 正在分析的顶层声明的序号
+	const SemanticAnalyzer* global_scope = nullptr;  // 并行分析时函数任务到这个分析器中查找全局变量
+	bool collect_errors = false;
+	std::vector<std::pair<size_t, std::string>> errors;  // 收集到的错误，连同所在顶层声明的序号
+
+private:
+	// 属性栈上的结点从这里分配，子结点合并进父结点后回收复用
+	SemanticTreeNode* acquire_node(const Symbol& symbol);
+	void release_node(SemanticTreeNode* node);
+
+	Arena node_arena;
+	std::vector<SemanticTreeNode*> free_nodes;
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// 单生产者单消费者的无锁环形队列
+// 只能由一个线程 push、另一个线程 pop；队列满或空时立即返回 false，由调用者决定如何等待
+template <typename T>
+class SpscQueue {
+public:
+	// 容量向上取整为 2 的幂
+	explicit SpscQueue(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity) size <<= 1;
+		buffer.resize(size);
+		mask = size - 1;
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	bool try_push(T&& value)
+	{
+		size_t current = tail.load(std::memory_order_relaxed);
+		if (current - head.load(std::memory_order_acquire) == buffer.size()) return false;
+
+		buffer[current & mask] = std::move(value);
+		tail.store(current + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool try_pop(T& value)
+	{
+		size_t current = head.load(std::memory_order_relaxed);
+		if (current == tail.load(std::memory_order_acquire)) return false;
+
+		value = std::move(buffer[current & mask]);
+		head.store(current + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	std::vector<T> buffer;
+	size_t mask;
+
+	// 生产者和消费者的位置放在不同的缓存行，避免伪共享
+	alignas(64) std::atomic<size_t> head{0};  // 下一个要读取的位置，只由消费者修改
+	alignas(64) std::atomic<size_t> tail{0};  // 下一个要写入的位置，只由生产者修改
+};
@@ -0,0 +1,31 @@
+#include "SymbolTable.hpp"
+
+void SymbolTable::pop_scope()
+{
+	if (scopes.empty()) return;
+	uint32_t begin = scopes.back();
+	scopes.pop_back();
+	for (size_t i = entries.size(); i > begin; --i) {
+		visible[entries[i - 1].name] = entries[i - 1].shadowed;
+	}
+	entries.resize(begin);
+}
+
+VaribleMeta* SymbolTable::declare(uint32_t name, const VaribleMeta& meta)
+{
+	if (name >= visible.size()) visible.resize(name + 1, none);
+
+	uint32_t current = visible[name];
+	uint32_t scope_begin = scopes.empty() ? 0 : scopes.back();
+	if (current != none && current >= scope_begin) return &entries[current].meta;
+
+	visible[name] = static_cast<uint32_t>(entries.size());
+	entries.push_back(Entry{name, current, meta});
+	return nullptr;
+}
+
+const VaribleMeta* SymbolTable::lookup(uint32_t name) const
+{
+	if (name >= visible.size() || visible[name] == none) return nullptr;
+	return &entries[visible[name]].meta;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Quater.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct VaribleMeta
+{
+	std::string type;   // 变量类型，int，float，char等
+	Operand value;      // 初始值(常量、变量或临时变量)，没有初始值时为空
+	size_t generation = 0;  // 登记该变量的那一轮分析，增量分析时用来区分旧声明和本轮的重定义
+	size_t declaration = 0;  // 所在顶层声明的序号，并行分析时函数只能看到在它之前声明的全局变量
+	// 同名的变量(或形参)在同一函数中声明了不止一次(包括遮蔽外层的同名变量)，或者各处声明的类型不同：
+	// 四元式中只有名字，看不出指的是哪一个，优化时不跟踪它的值
+	bool ambiguous = false;
+};
+
+// 按作用域嵌套的符号表，键为 Interner 中的名字编号
+// 名字编号是稠密的，每个名字直接按编号找到当前可见的那一项，查找不需要比较字符串
+// 进入作用域只记下当前的项数；退出时按登记的逆序撤销本层的项，恢复被它们遮蔽的外层项
+class SymbolTable {
+public:
+	void push_scope() { scopes.push_back(static_cast<uint32_t>(entries.size())); }
+	void pop_scope();
+	size_t depth() const { return scopes.size(); }
+
+	// 在当前作用域登记 name；本层已有同名的项时不登记，返回那一项，否则返回 nullptr
+	VaribleMeta* declare(uint32_t name, const VaribleMeta& meta);
+	// 当前可见的 name(最内层的那一项)，没有时返回 nullptr
+	const VaribleMeta* lookup(uint32_t name) const;
+
+private:
+	static constexpr uint32_t none = UINT32_MAX;
+
+	struct Entry
+	{
+		uint32_t name;
+		uint32_t shadowed;  // 被本项遮蔽的外层项在 entries 中的下标
+		VaribleMeta meta;
+	};
+
+	std::vector<uint32_t> visible;  // 名字编号 -> 当前可见的项在 entries 中的下标
+	std::vector<Entry> entries;     // 所有尚未退出的作用域中的项，按登记顺序
+	std::vector<uint32_t> scopes;   // 每层(全局作用域之外的)作用域第一项的下标
+};
@@ -0,0 +1,207 @@
+#include "TempSlots.hpp"
+#include "OutputBuffer.hpp"
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+TempSlots assign_temp_slots(const std::vector<std::pair<size_t, Quater>>& code,
+                            const std::map<std::string, VaribleMeta>& variables,
+                            const Interner& names,
+                            const std::vector<FunctionRange>& functions)
+{
+	const uint32_t none = TempSlots::none;
+	uint32_t size = static_cast<uint32_t>(code.size());
+
+	// 每个位置所属的分组：第 k 个函数为 k，函数之外的代码为 functions.size()；以及每组的最后一个位置
+	size_t global = functions.size();
+	std::vector<uint32_t> group(size, static_cast<uint32_t>(global));
+	for (size_t k = 0; k < functions.size(); ++k) {
+		std::fill(group.begin() + functions[k].begin, group.begin() + functions[k].end, static_cast<uint32_t>(k));
+	}
+	std::vector<uint32_t> group_end(global + 1, 0);
+	for (uint32_t i = 0; i < size; ++i) {
+		group_end[group[i]] = i;
+	}
+
+	// 每个临时变量第一次(定值)和最后一次出现的位置
+	std::vector<uint32_t> first, last;
+	for (uint32_t i = 0; i < size; ++i) {
+		const Quater& quater = code[i].second;
+		for (Operand operand : {quater.arg1, quater.arg2, quater.result}) {
+			names.for_each_temp(operand, [&](uint32_t temp) {
+				if (temp >= first.size()) {
+					first.resize(temp + 1, none);
+					last.resize(temp + 1, 0);
+				}
+				if (first[temp] == none) first[temp] = i;
+				last[temp] = i;
+			});
+		}
+	}
+	// 作为初始值的临时变量一直占用槽位，直到所在组的最后一条四元式之后
+	for (const auto& [name, meta] : variables) {
+		names.for_each_temp(meta.value, [&](uint32_t temp) {
+			if (temp < first.size() && first[temp] != none) last[temp] = std::max(last[temp], group_end[group[first[temp]]] + 1);
+		});
+	}
+
+	// 向后跳转(循环开始, 跳转位置)，按循环开始排序
+	std::vector<std::pair<uint32_t, uint32_t>> loops;
+	for (uint32_t i = 0; i < size; ++i) {
+		const Quater& quater = code[i].second;
+		if (quater.is_jump() && quater.result.index() <= i) loops.push_back({quater.result.index(), i});
+	}
+	std::sort(loops.begin(), loops.end());
+	for (uint32_t temp = 0; temp < first.size(); ++temp) {
+		if (first[temp] == none) continue;
+		// 循环开始在 (first, last] 之中：进入循环前已经定值，下一轮还可能用到
+		auto it = std::upper_bound(loops.begin(), loops.end(), std::make_pair(first[temp], none));
+		for (; it != loops.end() && it->first <= last[temp]; ++it) {
+			last[temp] = std::max(last[temp], it->second);
+		}
+	}
+
+	// 各组分别按开始位置扫描：先回收已经结束的区间，再分配编号最小的空闲槽位
+	std::vector<uint32_t> order;
+	for (uint32_t temp = 0; temp < first.size(); ++temp) {
+		if (first[temp] != none) order.push_back(temp);
+	}
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return std::make_pair(group[first[a]], first[a]) < std::make_pair(group[first[b]], first[b]);
+	});
+
+	TempSlots result;
+	result.slot.assign(first.size(), none);
+	std::vector<TempSlotUsage> usage(global + 1);
+	using Active = std::pair<uint32_t, uint32_t>;  // 区间结束位置, 槽位
+	std::priority_queue<Active, std::vector<Active>, std::greater<Active>> active;
+	std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> free_slots;
+	uint32_t current = none;
+	uint32_t slot_count = 0;
+	for (uint32_t temp : order) {
+		uint32_t g = group[first[temp]];
+		if (g != current) {
+			active = decltype(active)();
+			free_slots = decltype(free_slots)();
+			slot_count = 0;
+			current = g;
+		}
+		// 在同一条四元式中最后一次使用的临时变量，它的槽位可以给这条四元式的结果
+		while (!active.empty() && active.top().first <= first[temp]) {
+			free_slots.push(active.top().second);
+			active.pop();
+		}
+		uint32_t slot = slot_count;
+		if (free_slots.empty()) {
+			++slot_count;
+		} else {
+			slot = free_slots.top();
+			free_slots.pop();
+		}
+		result.slot[temp] = slot;
+		active.push({last[temp], slot});
+		++usage[g].temps;
+		usage[g].slots = slot_count;
+	}
+
+	// 全局变量的初始值在整个程序中都要保留，函数之外的槽位排在各函数用到的槽位之后，不与任何函数共用
+	uint32_t global_base = 0;
+	for (size_t k = 0; k < functions.size(); ++k) {
+		global_base = std::max(global_base, static_cast<uint32_t>(usage[k].slots));
+	}
+	for (uint32_t temp : order) {
+		if (group[first[temp]] == global) result.slot[temp] += global_base;
+	}
+
+	for (size_t k = 0; k < functions.size(); ++k) {
+		usage[k].function = functions[k].name;
+		result.usage.push_back(usage[k]);
+	}
+	if (usage[global].temps > 0) result.usage.push_back(usage[global]);
+	return result;
+}
+
+void apply_temp_slots(const TempSlots& slots,
+                      std::vector<std::pair<size_t, Quater>>& code,
+                      std::map<std::string, VaribleMeta>& variables,
+                      Interner& names)
+{
+	auto rename = [&slots](uint32_t temp) {
+		return temp < slots.slot.size() && slots.slot[temp] != TempSlots::none ? slots.slot[temp] : temp;
+	};
+	for (auto& [id, quater] : code) {
+		quater.arg1 = names.rename_temps(quater.arg1, rename);
+		quater.arg2 = names.rename_temps(quater.arg2, rename);
+		quater.result = names.rename_temps(quater.result, rename);
+	}
+	for (auto& [name, meta] : variables) {
+		meta.value = names.rename_temps(meta.value, rename);
+	}
+}
+
+void print_temp_slots(const std::vector<TempSlotUsage>& usage, std::ostream& out)
+{
+	OutputBuffer buffer(out);
+	if (usage.empty()) {
+		buffer << "Temp slot table is empty.";
+		buffer.end_line();
+		return;
+	}
+
+	// 函数之外的临时变量记为 (global)
+	auto function_text = [](const TempSlotUsage& item) { return item.function.empty() ? std::string_view("(global)") : std::string_view(item.function); };
+
+	size_t maxNameLength = std::string("Function").length();
+	size_t maxTempsLength = std::string("Temps").length();
+	size_t maxSlotsLength = std::string("Slots").length();
+	for (const auto& item : usage) {
+		maxNameLength = std::max(maxNameLength, function_text(item).length());
+		maxTempsLength = std::max(maxTempsLength, std::to_string(item.temps).length());
+		maxSlotsLength = std::max(maxSlotsLength, std::to_string(item.slots).length());
+	}
+	maxNameLength += 2;
+	maxTempsLength += 2;
+	maxSlotsLength += 2;
+
+	auto border = [&]() {
+		buffer << '+';
+		buffer.fill('-', maxNameLength);
+		buffer << '+';
+		buffer.fill('-', maxTempsLength);
+		buffer << '+';
+		buffer.fill('-', maxSlotsLength);
+		buffer << '+';
+		buffer.end_line();
+	};
+	border();
+	size_t cell = buffer.position() + 1;
+	buffer << "| Function ";
+	buffer.pad(cell, maxNameLength);
+	cell = buffer.position() + 1;
+	buffer << "| Temps ";
+	buffer.pad(cell, maxTempsLength);
+	cell = buffer.position() + 1;
+	buffer << "| Slots ";
+	buffer.pad(cell, maxSlotsLength);
+	buffer << '|';
+	buffer.end_line();
+	border();
+
+	for (const auto& item : usage) {
+		cell = buffer.position() + 1;
+		buffer << "| " << function_text(item);
+		buffer.pad(cell, maxNameLength);
+		cell = buffer.position() + 1;
+		buffer << "| ";
+		buffer.number(item.temps);
+		buffer.pad(cell, maxTempsLength);
+		cell = buffer.position() + 1;
+		buffer << "| ";
+		buffer.number(item.slots);
+		buffer.pad(cell, maxSlotsLength);
+		buffer << '|';
+		buffer.end_line();
+	}
+
+	border();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Interner.hpp"
+#include "SymbolTable.hpp"
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 一个函数中临时变量的个数，以及复用后需要的槽位数
+struct TempSlotUsage
+{
+	std::string function;  // 不属于任何函数的临时变量(全局变量的初始值)记在名字为空的一项中
+	size_t temps = 0;
+	size_t slots = 0;
+};
+
+// 临时变量到槽位的分配结果
+struct TempSlots
+{
+	static constexpr uint32_t none = UINT32_MAX;
+
+	std::vector<uint32_t> slot;        // 临时变量编号 -> 槽位编号，没有出现在代码中的为 none
+	std::vector<TempSlotUsage> usage;  // 按函数在代码中的顺序，全局的一项在最后
+};
+
+// 线性扫描：按活跃区间把临时变量分配到尽量少的槽位，区间不重叠的临时变量共用一个槽位
+// 临时变量不会跨函数，每个函数各自从槽位 0 开始分配；函数之外的代码(全局变量的初始值)使用排在所有函数之后的槽位
+// 区间从定值到最后一次使用；向后跳转时，在循环开始前就活跃、在循环中用到的临时变量延长到跳转处；
+// 变量表中作为初始值的临时变量在四元式之外还被引用，活跃到所在函数的末尾
+TempSlots assign_temp_slots(const std::vector<std::pair<size_t, Quater>>& code,
+                            const std::map<std::string, VaribleMeta>& variables,
+                            const Interner& names,
+                            const std::vector<FunctionRange>& functions);
+
+// 把代码和变量表中的临时变量换成所分配的槽位，槽位 k 仍写作 tk
+void apply_temp_slots(const TempSlots& slots,
+                      std::vector<std::pair<size_t, Quater>>& code,
+                      std::map<std::string, VaribleMeta>& variables,
+                      Interner& names);
+
+// 输出各函数的临时变量数和槽位数，格式与变量表相同
+void print_temp_slots(const std::vector<TempSlotUsage>& usage, std::ostream& out);
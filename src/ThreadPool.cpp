@@ -0,0 +1,114 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+	if (thread_count == 0) thread_count = 1;
+
+	for (size_t i = 0; i < thread_count; ++i) {
+		queues.push_back(std::make_unique<WorkQueue>());
+	}
+	for (size_t i = 0; i < thread_count; ++i) {
+		threads.emplace_back([this, i]() { worker_loop(i); });
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	wait();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	work_available.notify_all();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	// 先计数再入队：已经醒着的工作线程可能立即取走并执行这个任务，计数必须已经包含它
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		++queued;
+		++pending;
+	}
+	WorkQueue& queue = *queues[next_queue++ % queues.size()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+	work_available.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	all_done.wait(lock, [this]() { return pending == 0; });
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& body)
+{
+	std::mutex done_mutex;
+	std::condition_variable done;
+	size_t remaining = count;
+
+	for (size_t i = 0; i < count; ++i) {
+		submit([&, i]() {
+			body(i);
+			std::lock_guard<std::mutex> lock(done_mutex);
+			if (--remaining == 0) done.notify_one();
+		});
+	}
+
+	std::unique_lock<std::mutex> lock(done_mutex);
+	done.wait(lock, [&remaining]() { return remaining == 0; });
+}
+
+bool ThreadPool::pop_task(size_t index, std::function<void()>& task)
+{
+	// 先取自己队列的头部
+	{
+		WorkQueue& own = *queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.front());
+			own.tasks.pop_front();
+			return true;
+		}
+	}
+
+	// 再从其他队列的尾部窃取，和队列主人从两端取，减少争用
+	for (size_t offset = 1; offset < queues.size(); ++offset) {
+		WorkQueue& victim = *queues[(index + offset) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.back());
+			victim.tasks.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::worker_loop(size_t index)
+{
+	while (true) {
+		std::function<void()> task;
+		if (pop_task(index, task)) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				--queued;
+			}
+			task();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--pending == 0) all_done.notify_all();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		work_available.wait(lock, [this]() { return stopping || queued > 0; });
+		if (stopping && queued == 0) return;
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 工作窃取线程池：每个工作线程有自己的任务队列，自己的队列空了就从其他线程的队列尾部窃取
+// 提交的任务轮流分到各个队列，工作线程从队列头部取，因此大体上按提交顺序执行
+class ThreadPool {
+public:
+	explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+	// 等待已提交的任务全部完成后再退出
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// 任务不能抛出异常，需要报告的错误由任务自己捕获后记录
+	void submit(std::function<void()> task);
+	// 阻塞直到已提交的任务全部完成
+	void wait();
+	// 对 [0, count) 中的每个下标执行一次 body，阻塞直到这些任务完成(不等待其他任务)
+	// 调用线程只等待，不能在本线程池的工作线程中调用
+	void parallel_for(size_t count, const std::function<void(size_t)>& body);
+
+	size_t size() const { return threads.size(); }
+
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	void worker_loop(size_t index);
+	bool pop_task(size_t index, std::function<void()>& task);
+
+private:
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	std::vector<std::thread> threads;
+	std::atomic<size_t> next_queue{0};
+
+	std::mutex mutex;  // 保护下面的计数
+	std::condition_variable work_available;
+	std::condition_variable all_done;
+	size_t queued = 0;   // 已提交、尚未被取走的任务数
+	size_t pending = 0;  // 已提交、尚未完成的任务数
+	bool stopping = false;
+};
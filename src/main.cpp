@@ -1,68 +1,639 @@
-#include "Lexer.hpp"
-#include "LR1Parser.hpp"
-#include "SemanticAnalyzer.hpp"
-#include <iostream>
-#include <fstream>
-#include <sstream>
-
-void createLogFileIfNotExists(const std::string& filename)
-{
-	std::ofstream outfile(filename);
-	if (outfile) {
-		std::cout << "日志文件创建成功！" << std::endl;
-	} else {
-		std::cerr << "日志文件创建失败！" << std::endl;
-	}
-	outfile.close();
-}
-
-int main(int argc, char* argv[])
-{
-	if (argc < 3) {
-		std::cerr << "用法: " << argv[0] << " <输入文件> <文法文件>" << std::endl;
-		return 1;
-	}
-
-	// createLogFileIfNotExists("./output/test.log");
-	// freopen("./output/test.log", "w", stdout);
-
-	std::string inputFile = argv[1];
-	std::string grammarFile = argv[2];
-
-
-	std::ifstream file(inputFile);
-	if (!file.is_open()) {
-		std::cerr << "无法打开文件: " << inputFile << std::endl;
-		return 1;
-	}
-
-	std::stringstream buffer;
-	buffer << file.rdbuf();
-
-	std::string content = buffer.str();
-
-	Lexer lexer(content);
-	std::vector<Symbol> sentence;
-
-	Token token;
-	do {
-		token = lexer.getNextToken();
-		// std::cout << token.type_to_string() << " " << token.value << std::endl;
-		sentence.push_back(Symbol(SymbolType::Terminal, token.type_to_string(), token.value));
-	} while (token.type != T_EOF);
-
-	// LR1Parser parser1(grammarFile);
-	// parser1.save_tables("./test/grammer/table.cache");
-	LR1Parser parser;
-	parser.load_tables("./test/grammer/table.cache");
-
-	SemanticTreeNode* root = nullptr;
-	parser.parse(sentence, root);
-
-	SemanticAnalyzer analyzer(root);
-	analyzer.semantic_analyze();
-	analyzer.print_variable_table();
-	analyzer.print_intermediate_code();
-
-	return 0;
-}
+#include "Lexer.hpp"
+#include "BatchIO.hpp"
+#include "CompileCache.hpp"
+#include "LR1Parser.hpp"
+#include "SemanticAnalyzer.hpp"
+#include "TempSlots.hpp"
+#include "Optimizer.hpp"
+#include "IRWriter.hpp"
+#include "CompileContext.hpp"
+#include "CompileServer.hpp"
+#include "Pipeline.hpp"
+#include "ParseStats.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+std::vector<Symbol> tokenize(const std::string& content)
+{
+	Lexer lexer(content);
+	std::vector<Symbol> sentence;
+
+	Token token;
+	do {
+		token = lexer.getNextToken();
+		sentence.push_back(Symbol(SymbolType::Terminal, token.type_to_string(), token.value));
+	} while (token.type != T_EOF);
+	return sentence;
+}
+
+// 按顶层声明切分 token 序列：深度 0 处的 ';' 或回到深度 0 的 '}' 之后是一个声明的结束
+// 返回各段的起始下标，最后一项为终止符的下标
+std::vector<size_t> split_declarations(const std::vector<Symbol>& sentence)
+{
+	std::vector<size_t> boundaries = {0};
+	size_t end = sentence.size() - 1;  // 最后一个是 T_EOF
+	int depth = 0;
+	for (size_t i = 0; i < end; ++i) {
+		const std::string& type = sentence[i].literal;
+		if (type == "T_LEFT_BRACE") {
+			++depth;
+		} else if (type == "T_RIGHT_BRACE") {
+			if (--depth == 0) boundaries.push_back(i + 1);
+		} else if (type == "T_SEMICOLON" && depth == 0) {
+			boundaries.push_back(i + 1);
+		}
+	}
+	if (boundaries.back() != end) boundaries.push_back(end);
+	return boundaries;
+}
+
+// 用公共前缀和公共后缀确定两次输入之间被修改的 token 范围
+TokenEdit diff_tokens(const std::vector<Symbol>& before, const std::vector<Symbol>& after)
+{
+	auto same = [](const Symbol& a, const Symbol& b) { return a.literal == b.literal && a.real_value == b.real_value; };
+
+	size_t prefix = 0;
+	while (prefix < before.size() && prefix < after.size() && same(before[prefix], after[prefix])) ++prefix;
+
+	size_t suffix = 0;
+	while (suffix < before.size() - prefix && suffix < after.size() - prefix &&
+	       same(before[before.size() - 1 - suffix], after[after.size() - 1 - suffix])) {
+		++suffix;
+	}
+	return {prefix, before.size() - suffix, after.size() - suffix};
+}
+
+bool read_file(const std::string& path, std::string& content)
+{
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		std::cerr << "无法打开文件: " << path << std::endl;
+		return false;
+	}
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	content = buffer.str();
+	return true;
+}
+
+// 把整个 text 解析为非负整数，有多余的字符或超出范围时返回 false
+template <typename Integer>
+bool parse_count(const char* text, Integer& value)
+{
+	const char* end = text + std::strlen(text);
+	auto [ptr, error] = std::from_chars(text, end, value);
+	return error == std::errc() && ptr == end && ptr != text;
+}
+
+// 结果的输出形式：文本表格，或写到文件中的二进制中间代码(一次写出，或按函数分块写出)
+enum class EmitFormat {
+	TEXT,
+	IR_BIN,
+	IR_BIN_STREAM
+};
+
+struct CompileOptions
+{
+	bool compact_tree = false;         // 先建紧凑语法树再分析
+	bool translate_on_reduce = false;  // 归约时直接执行语义动作
+	bool pipeline = false;             // 词法、语法、语义分析分别在三个线程中流水进行
+	bool optimize = false;             // 常量折叠、常量和复写传播，并输出各函数优化前后的四元式条数
+	bool reuse_temps = false;          // 临时变量按活跃区间复用槽位，并输出各函数需要的槽位数
+	EmitFormat emit = EmitFormat::TEXT;
+	std::string ir_output;             // 二进制中间代码的输出文件
+	ThreadPool* parse_pool = nullptr;     // 非空时按顶层声明切分后并行做语法分析
+	ThreadPool* semantic_pool = nullptr;  // 非空时各函数的语义分析并行进行
+	CompileCache* cache = nullptr;        // 非空时先查编译缓存，编译成功的结果写回缓存
+};
+
+// 编译服务请求中只携带与单个文件有关的选项
+uint32_t request_flags(const CompileOptions& options)
+{
+	uint32_t flags = 0;
+	if (options.compact_tree) flags |= REQUEST_COMPACT_TREE;
+	if (options.translate_on_reduce) flags |= REQUEST_TRANSLATE_ON_REDUCE;
+	if (options.pipeline) flags |= REQUEST_PIPELINE;
+	if (options.reuse_temps) flags |= REQUEST_REUSE_TEMPS;
+	if (options.optimize) flags |= REQUEST_OPTIMIZE;
+	return flags;
+}
+
+// 输出变量表和中间代码；optimize 时先做常量折叠和传播，reuse_temps 时再把临时变量换成可复用的槽位，
+// 最后依次输出优化前后的四元式条数、各函数需要的槽位数
+// 两者都在副本上进行，缓存中保存的仍是分析得到的结果
+// 输出二进制中间代码时写到 ir_output，不再输出表格，写入失败时返回 false
+bool print_result(const std::vector<std::pair<size_t, Quater>>& code,
+                  const std::map<std::string, VaribleMeta>& variables,
+                  const Interner& names,
+                  const std::vector<FunctionRange>& functions,
+                  const CompileOptions& options,
+                  std::ostream& out)
+{
+	bool transform = options.optimize || options.reuse_temps;
+	std::vector<std::pair<size_t, Quater>> transformed_code;
+	std::map<std::string, VaribleMeta> transformed_variables;
+	Interner transformed_names;
+	std::vector<FunctionRange> transformed_functions;
+	if (transform) {
+		transformed_code = code;
+		transformed_variables = variables;
+		transformed_names = names;
+		transformed_functions = functions;
+	}
+
+	std::vector<QuadCount> counts;
+	if (options.optimize) counts = optimize_quads(transformed_code, transformed_variables, transformed_names, transformed_functions);
+	TempSlots slots;
+	if (options.reuse_temps) {
+		slots = assign_temp_slots(transformed_code, transformed_variables, transformed_names, transformed_functions);
+		apply_temp_slots(slots, transformed_code, transformed_variables, transformed_names);
+	}
+	const auto& result_code = transform ? transformed_code : code;
+	const auto& result_variables = transform ? transformed_variables : variables;
+	const auto& result_names = transform ? transformed_names : names;
+	const auto& result_functions = transform ? transformed_functions : functions;
+
+	if (options.emit != EmitFormat::TEXT) {
+		bool written = options.emit == EmitFormat::IR_BIN ? write_ir(options.ir_output, result_code, result_variables, result_names, result_functions)
+		                                                  : write_ir_stream(options.ir_output, result_code, result_variables, result_names, result_functions);
+		if (!written) std::cerr << "无法写入文件: " << options.ir_output << std::endl;
+		return written;
+	}
+
+	SemanticAnalyzer::print_variable_table(result_variables, result_names, out);
+	SemanticAnalyzer::print_intermediate_code(result_code, result_names, out);
+	if (options.optimize) print_quad_counts(counts, out);
+	if (options.reuse_temps) print_temp_slots(slots.usage, out);
+	return true;
+}
+
+// 流式编译(--emit=ir-bin-stream)：归约时翻译，每个顶层声明分析完就作为一块写到 ir_output，随即释放它的四元式，
+// 内存只与最大的一个声明有关；变量表要到最后才完整，放在最后一块中
+// 中途出错时文件没有最后一块，IRReader 不会接受它
+int compile_streaming(const LR1Parser& parser, const std::string& content, const CompileOptions& options, std::ostream& out)
+{
+	Lexer lexer(content);
+	TokenSource next_token = [&lexer]() {
+		Token token = lexer.getNextToken();
+		return Symbol(SymbolType::Terminal, token.type_to_string(), token.value);
+	};
+
+	IRStreamWriter writer;
+	if (!writer.open(options.ir_output)) {
+		std::cerr << "无法写入文件: " << options.ir_output << std::endl;
+		return 1;
+	}
+
+	CompileContext context;
+	int code = 0;
+	try {
+		SemanticAnalyzer analyzer(context.root, parser.get_productions());
+		// 没有代码的全局变量声明不单独成块，它新增的名字随下一块写出
+		SemanticAnalyzer::DeclarationSink sink = [&](const std::vector<std::pair<size_t, Quater>>& quads, const std::string& function) {
+			if (function.empty()) {
+				if (!quads.empty()) writer.write_chunk(quads.data(), quads.size(), analyzer.get_interner(), nullptr);
+				return;
+			}
+			FunctionRange range{function, writer.written_quads(), writer.written_quads() + quads.size()};
+			writer.write_chunk(quads.data(), quads.size(), analyzer.get_interner(), &range);
+		};
+		std::exception_ptr semantic_error;
+		if (!analyzer.translate_streaming(parser, next_token, context.arena, sink, semantic_error)) {
+			code = 1;
+		} else {
+			out << "Accept" << std::endl;
+			if (semantic_error) std::rethrow_exception(semantic_error);
+			if (!writer.finish(analyzer.get_variable_table(), analyzer.get_interner())) {
+				std::cerr << "无法写入文件: " << options.ir_output << std::endl;
+				code = 1;
+			}
+		}
+	} catch (const SemanticError& error) {
+		out << error.what() << std::endl;
+		code = -1;
+	}
+
+	PARSE_STATS_FLUSH();
+	return code;
+}
+
+// 打开编译缓存时截下本次编译的词法错误，分析结束后照常写到原来的位置
+// 命中缓存时不再做词法分析，所以报告过词法错误的结果不能进入缓存，否则再次编译时这些信息会丢失
+class LexerErrorCapture {
+public:
+	explicit LexerErrorCapture(bool active) : previous(Lexer::get_error_output()), active(active)
+	{
+		if (active) Lexer::set_error_output(&captured);
+	}
+	~LexerErrorCapture() { release(); }
+
+	LexerErrorCapture(const LexerErrorCapture&) = delete;
+	LexerErrorCapture& operator=(const LexerErrorCapture&) = delete;
+
+	// 恢复原来的输出位置，并把截下的错误信息写过去
+	void release()
+	{
+		if (!active) return;
+		active = false;
+		Lexer::set_error_output(previous);
+		std::string text = captured.str();
+		reported = !text.empty();
+		(previous != nullptr ? *previous : std::cout) << text;
+	}
+	bool reported_errors() const { return reported; }
+
+private:
+	std::ostream* previous;
+	std::ostringstream captured;
+	bool active;
+	bool reported = false;
+};
+
+// 编译一份源代码，结果写到 out，返回值即进程退出码：0 成功，1 语法错误，-1 语义错误
+// 每次调用都有自己的词法分析器、语法树和语义分析器，parser 只读，可以在多个线程中同时调用
+int compile_source(const LR1Parser& parser, const std::string& content, const CompileOptions& options, std::ostream& out)
+{
+	// 优化和复用临时变量要看整个程序的代码，只能先完整编译，再按函数分块写出
+	if (options.emit == EmitFormat::IR_BIN_STREAM && !options.optimize && !options.reuse_temps) return compile_streaming(parser, content, options, out);
+
+	// 命中缓存时直接输出上次的结果，不再做词法、语法和语义分析
+	CacheKey cacheKey;
+	if (options.cache != nullptr) {
+		cacheKey = options.cache->key(content, request_flags(options));
+		std::vector<std::pair<size_t, Quater>> code;
+		std::map<std::string, VaribleMeta> variables;
+		Interner names;
+		std::vector<FunctionRange> functions;
+		if (options.cache->lookup(cacheKey, code, variables, names, functions)) {
+			out << "Accept" << std::endl;
+			return print_result(code, variables, names, functions, options, out) ? 0 : 1;
+		}
+	}
+
+	LexerErrorCapture lexerErrors(options.cache != nullptr);
+
+	// 语法分析器移进时才向词法分析器要下一个 token，不再预先保存整个 token 序列
+	Lexer lexer(content);
+	TokenSource next_token = [&lexer]() {
+		Token token = lexer.getNextToken();
+		// std::cout << token.type_to_string() << " " << token.value << std::endl;
+		return Symbol(SymbolType::Terminal, token.type_to_string(), token.value);
+	};
+
+	CompileContext context;
+	CompactTree tree;
+	int code = 0;
+	try {
+		bool accepted = true;
+		SemanticAnalyzer analyzer(context.root, parser.get_productions());
+		std::exception_ptr semantic_error;
+		if (options.pipeline) {
+			accepted = compile_pipelined(parser, content, context, analyzer, semantic_error);
+		} else if (options.translate_on_reduce) {
+			// 边归约边翻译，语义分析的时间计入 parse
+			accepted = analyzer.translate(parser, next_token, context.arena, semantic_error);
+		} else if (options.compact_tree) {
+			accepted = parser.parse(next_token, tree);
+		} else if (options.parse_pool != nullptr) {
+			std::vector<Symbol> sentence = tokenize(content);
+			accepted = parser.parse_parallel(sentence,
+			                                 split_declarations(sentence),
+			                                 Symbol(SymbolType::NonTerminal, "declaration"),
+			                                 context.root,
+			                                 context.arena,
+			                                 *options.parse_pool);
+		} else {
+			accepted = parser.parse(next_token, context.root, context.arena);
+		}
+		// 词法分析已经结束，错误信息仍在 Accept 之前输出
+		lexerErrors.release();
+
+		if (!accepted) {
+			code = 1;
+		} else {
+			out << "Accept" << std::endl;
+			if (semantic_error) std::rethrow_exception(semantic_error);
+			if (!options.pipeline && !options.translate_on_reduce) {
+				PARSE_STATS_PHASE("semantic");
+				if (options.compact_tree) {
+					analyzer.semantic_analyze(tree);
+				} else if (options.semantic_pool != nullptr) {
+					analyzer.semantic_analyze_parallel(*options.semantic_pool);
+				} else {
+					analyzer.semantic_analyze();
+				}
+			}
+			auto intermediate_code = analyzer.get_intermediate_code();
+			auto functions = analyzer.get_functions();
+			if (!print_result(intermediate_code, analyzer.get_variable_table(), analyzer.get_interner(), functions, options, out)) code = 1;
+			if (options.cache != nullptr && !lexerErrors.reported_errors()) {
+				options.cache->store(cacheKey, intermediate_code, analyzer.get_variable_table(), analyzer.get_interner(), functions);
+			}
+		}
+	} catch (const SemanticError& error) {
+		out << error.what() << std::endl;
+		code = -1;
+	}
+
+	PARSE_STATS_FLUSH();
+	return code;
+}
+
+// 批量编译：输入可以是文件或目录(目录下的文件按名字排序)
+// 所有文件共用一个只读的语法分析器，在线程池中并发编译，结果按输入顺序输出
+int compile_batch(const LR1Parser& parser,
+                  const std::vector<std::string>& inputs,
+                  const CompileOptions& options,
+                  size_t jobs,
+                  const std::string& outputDir)
+{
+	std::vector<std::string> files;
+	for (const std::string& input : inputs) {
+		if (std::filesystem::is_directory(input)) {
+			std::vector<std::string> entries;
+			for (const auto& entry : std::filesystem::directory_iterator(input)) {
+				if (entry.is_regular_file()) entries.push_back(entry.path().string());
+			}
+			std::sort(entries.begin(), entries.end());
+			files.insert(files.end(), entries.begin(), entries.end());
+		} else {
+			files.push_back(input);
+		}
+	}
+
+	struct BatchResult
+	{
+		int code;
+		std::string output;
+	};
+
+	if (!outputDir.empty()) std::filesystem::create_directories(outputDir);
+
+	// 文件读写交给 BatchIO 异步进行：始终提前提交 readAhead 个文件的读取，
+	// 读完一个就交给线程池编译；编译结果按输入顺序输出，已经完成的结果在提交新任务的间隙就写出去
+	const size_t readAhead = 64;
+	BatchIO io(readAhead);
+	ThreadPool pool(jobs);
+	std::vector<std::future<FileData>> contents(files.size());
+	std::vector<std::future<BatchResult>> results;
+	std::vector<std::pair<size_t, std::future<bool>>> writes;
+	size_t failed = 0;
+	size_t emitted = 0;
+
+	auto outputFile = [&](size_t i) {
+		return (std::filesystem::path(outputDir) / std::filesystem::path(files[i]).filename()).string() + ".out";
+	};
+	auto emit = [&](size_t i) {
+		BatchResult result = results[i].get();
+		if (result.code != 0) ++failed;
+
+		if (outputDir.empty()) {
+			std::cout << "==> " << files[i] << " <==\n" << result.output;
+			return;
+		}
+		writes.push_back({i, io.write(outputFile(i), std::move(result.output))});
+	};
+
+	for (size_t i = 0; i < files.size() && i < readAhead; ++i) {
+		contents[i] = io.read(files[i]);
+	}
+	for (size_t i = 0; i < files.size(); ++i) {
+		auto file = std::make_shared<FileData>(contents[i].get());
+		if (i + readAhead < files.size()) contents[i + readAhead] = io.read(files[i + readAhead]);
+
+		auto task = std::make_shared<std::packaged_task<BatchResult()>>([&parser, &options, &files, file, i]() {
+			if (!file->ok) {
+				std::cerr << "无法打开文件: " << files[i] << std::endl;
+				return BatchResult{1, ""};
+			}
+			// 词法、语法错误和语义错误一样写到这个文件自己的输出中，不与其他线程的混在一起
+			std::ostringstream out;
+			Lexer::set_error_output(&out);
+			LR1Parser::set_error_output(&out);
+			int code = compile_source(parser, file->content, options, out);
+			Lexer::set_error_output(nullptr);
+			LR1Parser::set_error_output(nullptr);
+			return BatchResult{code, out.str()};
+		});
+		results.push_back(task->get_future());
+		pool.submit([task]() { (*task)(); });
+
+		while (emitted < results.size() && results[emitted].wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+			emit(emitted++);
+		}
+	}
+	while (emitted < files.size()) emit(emitted++);
+
+	for (auto& [i, written] : writes) {
+		if (written.get()) continue;
+		std::cerr << "无法写入文件: " << outputFile(i) << std::endl;
+		++failed;
+	}
+	std::cout.flush();
+
+	std::cerr << "共编译 " << files.size() << " 个文件，失败 " << failed << " 个" << std::endl;
+	return failed == 0 ? 0 : 1;
+}
+
+void createLogFileIfNotExists(const std::string& filename)
+{
+	std::ofstream outfile(filename);
+	if (outfile) {
+		std::cout << "日志文件创建成功！" << std::endl;
+	} else {
+		std::cerr << "日志文件创建失败！" << std::endl;
+	}
+	outfile.close();
+}
+
+int main(int argc, char* argv[])
+{
+	// 以 -- 开头的参数为选项，其余为位置参数
+	std::vector<std::string> positional;
+	CompileOptions options;
+	bool elideUnitReductions = false;
+	std::string reparseFile;
+	bool batch = false;
+	bool parallelParse = false;
+	bool parallelSemantic = false;
+	size_t jobs = std::thread::hardware_concurrency();
+	std::string outputDir;
+	std::string serveSocket;
+	std::string clientSocket;
+	std::string cacheDir;
+	uint64_t cacheSizeMB = 256;
+	bool badArgument = false;  // 选项的值不合法，输出用法后退出
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--reparse" && i + 1 < argc) {
+			reparseFile = argv[++i];
+		} else if (arg == "--compact-tree") {
+			options.compact_tree = true;
+		} else if (arg == "--elide-units") {
+			elideUnitReductions = true;
+		} else if (arg == "--translate-on-reduce") {
+			options.translate_on_reduce = true;
+		} else if (arg == "--pipeline") {
+			options.pipeline = true;
+		} else if (arg == "--reuse-temps") {
+			options.reuse_temps = true;
+		} else if (arg == "--optimize") {
+			options.optimize = true;
+		} else if (arg == "--emit=ir-bin") {
+			options.emit = EmitFormat::IR_BIN;
+		} else if (arg == "--emit=ir-bin-stream") {
+			options.emit = EmitFormat::IR_BIN_STREAM;
+		} else if (arg == "--ir-out" && i + 1 < argc) {
+			options.ir_output = argv[++i];
+		} else if (arg == "--parallel-parse") {
+			parallelParse = true;
+		} else if (arg == "--parallel-semantic") {
+			parallelSemantic = true;
+		} else if (arg == "--serve" && i + 1 < argc) {
+			serveSocket = argv[++i];
+		} else if (arg == "--client" && i + 1 < argc) {
+			clientSocket = argv[++i];
+		} else if (arg == "--batch") {
+			batch = true;
+		} else if (arg == "--jobs" && i + 1 < argc) {
+			if (!parse_count(argv[++i], jobs)) badArgument = true;
+		} else if (arg == "--out-dir" && i + 1 < argc) {
+			outputDir = argv[++i];
+		} else if (arg == "--cache-dir" && i + 1 < argc) {
+			cacheDir = argv[++i];
+		} else if (arg == "--cache-size" && i + 1 < argc) {
+			if (!parse_count(argv[++i], cacheSizeMB)) badArgument = true;
+		} else {
+			positional.push_back(arg);
+		}
+	}
+
+	bool needsInput = serveSocket.empty();
+	if (badArgument || (needsInput && (batch ? positional.empty() : positional.size() < 2))) {
+		std::cerr << "用法: " << argv[0] << " <输入文件> <文法文件> [--compact-tree] [--elide-units] [--translate-on-reduce] [--pipeline] [--parallel-parse] [--parallel-semantic] [--optimize] [--reuse-temps] [--emit=ir-bin|--emit=ir-bin-stream] [--ir-out <输出文件>] [--jobs <线程数>] [--reparse <修改后的输入文件>] [--cache-dir <缓存目录>] [--cache-size <MB>]\n"
+		          << "      " << argv[0] << " --batch <输入文件或目录>... [--jobs <线程数>] [--out-dir <输出目录>] [--cache-dir <缓存目录>] [--compact-tree] [--elide-units] [--translate-on-reduce] [--optimize] [--reuse-temps]\n"
+		          << "      " << argv[0] << " --serve <套接字路径> [--jobs <线程数>] [--cache-dir <缓存目录>] [--elide-units]\n"
+		          << "      " << argv[0] << " --client <套接字路径> <输入文件> <文法文件> [--compact-tree] [--translate-on-reduce] [--pipeline] [--optimize] [--reuse-temps]" << std::endl;
+		return 1;
+	}
+
+	// 二进制中间代码写到一个文件中，只用于单个文件的编译，默认写到 <输入文件>.ir
+	if (options.emit != EmitFormat::TEXT) {
+		if (batch || !serveSocket.empty() || !clientSocket.empty()) {
+			std::cerr << "--emit=ir-bin 只能用于单个文件的编译" << std::endl;
+			return 1;
+		}
+		if (options.ir_output.empty()) options.ir_output = positional[0] + ".ir";
+	}
+
+	// 客户端只把源代码交给编译服务，不需要加载分析表
+	if (!clientSocket.empty()) {
+		std::string content;
+		if (!read_file(positional[0], content)) return 1;
+		return run_compile_client(clientSocket, content, request_flags(options), std::cout, std::cerr);
+	}
+
+	// createLogFileIfNotExists("./output/test.log");
+	// freopen("./output/test.log", "w", stdout);
+
+	// LR1Parser parser1(grammarFile);
+	// parser1.save_tables("./test/grammer/table.cache");
+	LR1Parser parser;
+	{
+		PARSE_STATS_PHASE("load_tables");
+		if (!parser.load_tables("./test/grammer/table.cache")) {
+			std::cerr << "文件打开失败！" << std::endl;
+			return -1;
+		}
+	}
+#ifdef PARSE_STATS
+	ParseStats::dump_at_exit("./output/parse_stats.json", parser.get_productions());
+#endif
+	parser.set_elide_unit_reductions(elideUnitReductions);
+	PARSE_STATS_FLUSH();
+
+	// 缓存键包含分析表的内容，分析表重新生成后旧的结果自动失效
+	std::unique_ptr<CompileCache> cache;
+	if (!cacheDir.empty()) {
+		std::string tables;
+		if (!read_file("./test/grammer/table.cache", tables)) return -1;
+		cache = std::make_unique<CompileCache>(cacheDir, cacheSizeMB * 1024 * 1024, tables);
+		options.cache = cache.get();
+	}
+
+	if (batch) {
+		return compile_batch(parser, positional, options, jobs, outputDir);
+	}
+
+	if (!serveSocket.empty()) {
+		// 每个请求在工作线程中独立编译，各自使用自己的 CompileContext(arena)
+		CompileHandler handler = [&parser, &options](const std::string& source, uint32_t flags, std::ostream& out, std::ostream& diagnostics) {
+			// 与命令行编译相同：词法错误写到输出，语法错误写到诊断信息
+			Lexer::set_error_output(&out);
+			LR1Parser::set_error_output(&diagnostics);
+			CompileOptions requestOptions;
+			requestOptions.compact_tree = flags & REQUEST_COMPACT_TREE;
+			requestOptions.translate_on_reduce = flags & REQUEST_TRANSLATE_ON_REDUCE;
+			requestOptions.pipeline = flags & REQUEST_PIPELINE;
+			requestOptions.reuse_temps = flags & REQUEST_REUSE_TEMPS;
+			requestOptions.optimize = flags & REQUEST_OPTIMIZE;
+			requestOptions.cache = options.cache;
+			int code = compile_source(parser, source, requestOptions, out);
+			Lexer::set_error_output(nullptr);
+			LR1Parser::set_error_output(nullptr);
+			return code;
+		};
+		return run_compile_server(serveSocket, handler, jobs);
+	}
+
+	std::string inputFile = positional[0];
+	std::string grammarFile = positional[1];
+
+	std::string content;
+	if (!read_file(inputFile, content)) return 1;
+
+	if (!reparseFile.empty()) {
+		// 增量模式：先完整编译原输入，再对修改后的输入只重新分析受影响的部分，输出修改后的结果
+		std::string edited;
+		if (!read_file(reparseFile, edited)) return 1;
+
+		std::vector<Symbol> before = tokenize(content);
+		std::vector<Symbol> after = tokenize(edited);
+
+		CompileContext context;
+		if (!parser.parse(before, context.root, context.arena)) return 1;
+		int code = 0;
+		try {
+			SemanticAnalyzer analyzer(context.root, parser.get_productions());
+			analyzer.semantic_analyze();
+
+			// 旧树和新树共用同一个 arena，复用的子树在新树中仍然有效
+			SemanticTreeNode* root = nullptr;
+			if (!parser.reparse(after, context.root, diff_tokens(before, after), root, context.arena)) return 1;
+			std::cout << "Accept" << std::endl;
+			context.root = root;
+			analyzer.reanalyze(root);
+			if (!print_result(analyzer.get_intermediate_code(), analyzer.get_variable_table(), analyzer.get_interner(), analyzer.get_functions(), options, std::cout)) code = 1;
+		} catch (const SemanticError& error) {
+			// 原输入有语义错误时输出的是原输入的错误
+			std::cout << error.what() << std::endl;
+			code = -1;
+		}
+		PARSE_STATS_FLUSH();
+		return code;
+	}
+
+	// 批量模式下各文件已经并行编译，只在单文件时并行做语法分析和语义分析
+	std::unique_ptr<ThreadPool> pool;
+	if (parallelParse || parallelSemantic) pool = std::make_unique<ThreadPool>(jobs);
+	if (parallelParse) options.parse_pool = pool.get();
+	if (parallelSemantic) options.semantic_pool = pool.get();
+	return compile_source(parser, content, options, std::cout);
+}
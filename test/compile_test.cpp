@@ -0,0 +1,79 @@
+// 进程内编译接口(src/Compiler.hpp)的测试程序：只链接 libtranslator.a，不经过 main.cpp
+// 在仓库根目录运行：./output/CompileTest，全部通过时返回 0
+#include "../src/Compiler.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+	int failures = 0;
+
+	void check(bool condition, const std::string& what)
+	{
+		if (condition) return;
+		std::cerr << "失败: " << what << std::endl;
+		++failures;
+	}
+
+	bool contains(const std::vector<std::string>& lines, const std::string& text)
+	{
+		for (const std::string& line : lines) {
+			if (line.find(text) != std::string::npos) return true;
+		}
+		return false;
+	}
+
+	// 四元式按输出中的写法拼成一个字符串，用来比较两次编译的结果
+	std::string code_text(const CompileResult& result)
+	{
+		std::string text;
+		for (const auto& [id, quater] : result.code) {
+			text += result.names.to_string(quater);
+			text += '\n';
+		}
+		return text;
+	}
+}  // namespace
+
+int main()
+{
+	Tables tables;
+	if (!load_tables("./test/grammer/table.cache", tables)) {
+		std::cerr << "无法加载分析表 ./test/grammer/table.cache" << std::endl;
+		return 1;
+	}
+
+	std::ifstream file("./test/input/input.txt");
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	const std::string source = buffer.str();
+
+	// 正确的程序：有中间代码和变量表，没有错误信息
+	CompileResult result = compile(source, tables);
+	check(result.ok(), "input.txt 应编译成功");
+	check(!result.code.empty(), "input.txt 应生成中间代码");
+	check(result.variables.count("sum") == 1, "变量表中应有 sum");
+	check(result.diagnostics.empty(), "input.txt 不应有错误信息");
+
+	// 同一份分析表反复编译，结果相同
+	CompileResult again = compile(source, tables);
+	check(code_text(again) == code_text(result), "重复编译的中间代码应相同");
+
+	// 语法错误：返回 1，错误信息不写到标准输出
+	CompileResult syntax = compile("int main() { int x; x = ; }", tables);
+	check(syntax.status == 1, "语法错误应返回 1");
+	check(contains(syntax.diagnostics, "Parse error"), "应报告语法错误");
+
+	// 语义错误：返回 -1
+	CompileResult semantic = compile("int main() { x = 1; return 0; }", tables);
+	check(semantic.status == -1, "语义错误应返回 -1");
+	check(contains(semantic.diagnostics, "未定义变量"), "应报告未定义变量");
+
+	// 词法错误与其他信息一起收集
+	CompileResult lexical = compile("int main() { return 0; }\n/* open", tables);
+	check(contains(lexical.diagnostics, "Unclosed multi-line comment"), "应报告未闭合的注释");
+
+	if (failures > 0) return 1;
+	std::cout << "compile_test: 全部通过" << std::endl;
+	return 0;
+}